@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+# Generates LLVM IR to benchmark the bounds check pass with. The IR has the shape clang emits at
+# -O0: every local lives in an alloca, so the memory mode runs on it as is and the SSA mode after
+# -mem2reg. All sizes are controlled from the command line, the output only depends on them and
+# the seed.
+
+import argparse
+import random
+import sys
+
+
+class FunctionWriter:
+    def __init__(self, args, name, rng):
+        self.args = args
+        self.name = name
+        self.rng = rng
+        self.lines = []
+        self.next_value = 0
+        self.next_block = 0
+        self.blocks = 0
+
+    def value(self):
+        self.next_value += 1
+        return "%v" + str(self.next_value)
+
+    def label(self, prefix):
+        self.next_block += 1
+        return prefix + str(self.next_block)
+
+    def emit(self, line):
+        self.lines.append("  " + line)
+
+    def start_block(self, label):
+        self.lines.append(label + ":")
+        self.blocks += 1
+
+    def local(self):
+        return "%local" + str(self.rng.randrange(self.args.locals))
+
+    def load(self, pointer):
+        value = self.value()
+        self.emit("{} = load i32, i32* {}".format(value, pointer))
+        return value
+
+    def access(self, index):
+        """An array access at index, an i32 value."""
+        wide = self.value()
+        self.emit("{} = sext i32 {} to i64".format(wide, index))
+        element = self.value()
+        self.emit("{} = getelementptr inbounds [{} x i32], [{} x i32]* %array, i64 0, i64 {}".format(
+            element, self.args.array_size, self.args.array_size, wide))
+        self.emit("store i32 {}, i32* {}".format(index, element))
+
+    def plain_block(self, inductions):
+        """GEPs indexed by induction variables and locals, and a few updates of the locals."""
+        for _ in range(self.args.geps_per_block):
+            if inductions and self.rng.random() < 0.7:
+                index = self.load(self.rng.choice(inductions))
+            else:
+                index = self.load(self.local())
+            offset = self.rng.randrange(-2, 3)
+            if offset:
+                moved = self.value()
+                self.emit("{} = add nsw i32 {}, {}".format(moved, index, offset))
+                index = moved
+            self.access(index)
+
+        target = self.local()
+        current = self.load(target)
+        updated = self.value()
+        self.emit("{} = {} nsw i32 {}, {}".format(updated, self.rng.choice(["add", "sub", "mul"]),
+                                                 current, self.rng.randrange(1, 4)))
+        self.emit("store i32 {}, i32* {}".format(updated, target))
+
+    def switch(self, inductions, join):
+        """A switch on a local, each case stores a constant and all of them meet at join."""
+        condition = self.load(self.local())
+        cases = [self.label("case") for _ in range(self.args.switch_fanin)]
+        self.emit("switch i32 {}, label %{} [".format(condition, join))
+        for number, case in enumerate(cases):
+            self.emit("  i32 {}, label %{}".format(number, case))
+        self.emit("]")
+
+        for case in cases:
+            self.start_block(case)
+            self.emit("store i32 {}, i32* {}".format(self.rng.randrange(self.args.array_size), self.local()))
+            if inductions:
+                self.access(self.load(inductions[-1]))
+            self.emit("br label %" + join)
+
+    def body(self, inductions, blocks):
+        """At least blocks blocks without loops, alternating plain blocks and switches."""
+        current = self.label("body")
+        self.emit("br label %" + current)
+        while blocks > 0:
+            self.start_block(current)
+            self.plain_block(inductions)
+            following = self.label("body")
+            if self.args.switch_fanin and self.rng.random() < 0.3:
+                self.switch(inductions, following)
+                blocks -= self.args.switch_fanin + 1
+            else:
+                self.emit("br label %" + following)
+                blocks -= 1
+            current = following
+        self.start_block(current)
+
+    def loop(self, depth, inductions, blocks):
+        """A counted loop around a loop of depth - 1, the innermost one holds the body."""
+        if depth == 0:
+            self.body(inductions, blocks)
+            return
+
+        induction = "%i" + str(depth)
+        header = self.label("header")
+        exit_block = self.label("exit")
+        self.emit("store i32 0, i32* " + induction)
+        self.emit("br label %" + header)
+
+        self.start_block(header)
+        current = self.load(induction)
+        done = self.value()
+        bound = self.rng.choice([self.args.array_size, self.args.array_size - self.rng.randrange(5)])
+        self.emit("{} = icmp slt i32 {}, {}".format(done, current, bound))
+        entry = self.label("loop")
+        self.emit("br i1 {}, label %{}, label %{}".format(done, entry, exit_block))
+
+        self.start_block(entry)
+        self.loop(depth - 1, inductions + [induction], blocks)
+        current = self.load(induction)
+        next_value = self.value()
+        self.emit("{} = add nsw i32 {}, 1".format(next_value, current))
+        self.emit("store i32 {}, i32* {}".format(next_value, induction))
+        self.emit("br label %" + header)
+
+        self.start_block(exit_block)
+
+    def write(self):
+        self.lines.append("define i32 @{}() {{".format(self.name))
+        self.start_block("entry")
+        self.emit("%array = alloca [{} x i32]".format(self.args.array_size))
+        for depth in range(1, self.args.loop_depth + 1):
+            self.emit("%i{} = alloca i32".format(depth))
+        for number in range(self.args.locals):
+            self.emit("%local{} = alloca i32".format(number))
+        for number in range(self.args.locals):
+            self.emit("store i32 {}, i32* %local{}".format(self.rng.randrange(self.args.array_size), number))
+
+        self.loop(self.args.loop_depth, [], self.args.blocks)
+        self.emit("ret i32 0")
+        self.lines.append("}")
+        return "\n".join(self.lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--functions", type=int, default=1, help="functions in the module")
+    parser.add_argument("--blocks", type=int, default=100, help="blocks per function, without loop blocks")
+    parser.add_argument("--locals", type=int, default=10, help="scalar locals per function")
+    parser.add_argument("--loop-depth", type=int, default=2, help="depth of the loop nest")
+    parser.add_argument("--switch-fanin", type=int, default=4, help="cases of each switch, 0 for none")
+    parser.add_argument("--geps-per-block", type=int, default=2, help="array accesses per block")
+    parser.add_argument("--array-size", type=int, default=100, help="elements of the array accessed")
+    parser.add_argument("--seed", type=int, default=0, help="seed of the random choices")
+    parser.add_argument("-o", "--output", default="-", help="file to write, - for stdout")
+    args = parser.parse_args()
+
+    if args.locals < 1 or args.array_size < 5:
+        parser.error("need at least one local and an array of at least 5 elements")
+
+    rng = random.Random(args.seed)
+    functions = [FunctionWriter(args, "bench" + str(number), rng).write() for number in range(args.functions)]
+
+    output = sys.stdout if args.output == "-" else open(args.output, "w")
+    output.write("; generated by generate_ir.py {}\n\n".format(" ".join(sys.argv[1:])))
+    output.write("\n\n".join(functions) + "\n")
+    if output is not sys.stdout:
+        output.close()
+
+
+if __name__ == "__main__":
+    main()
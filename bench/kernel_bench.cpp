@@ -0,0 +1,135 @@
+// Times the interval kernels of VariableRange.h against the all-combinations transfer they
+// replaced: every bound of one side with every bound of the other, through a switch on the
+// operator and a clamp per combination. Its division takes -1 and 1 like the kernel does. Prints
+// a JSON line per operator with the nanoseconds per transfer of both and how many results differ.
+
+// Project Includes
+#include "VariableRange.h"
+
+// STL Includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace {
+    // ================== ALL COMBINATIONS ================== //
+
+    // The operator on one bound of each side, clamped to the int range
+    int combineBounds(long long lhs, long long rhs, char op) {
+        long long result;
+        switch (op) {
+            case '+':
+                result = lhs + rhs;
+                break;
+            case '-':
+                result = lhs - rhs;
+                break;
+            case '*':
+                result = lhs * rhs;
+                break;
+            default:
+                if (rhs == 0) {
+                    return static_cast<int>(lhs);
+                }
+                result = lhs / rhs;
+                break;
+        }
+        return result > INT_MAX ? INT_MAX : result < INT_MIN ? INT_MIN : static_cast<int>(result);
+    }
+
+    VariableRange allCombinations(const VariableRange& lhs, const VariableRange& rhs, char op) {
+        if (op == '/' && rhs.min_value == 0 && rhs.max_value == 0) {
+            return VariableRange();
+        }
+
+        int bounds[] = {lhs.min_value, lhs.max_value};
+        int others[] = {rhs.min_value, rhs.max_value, rhs.min_value, rhs.max_value};
+
+        // Dividing by -1 or 1 can give the extremes, if rhs holds them
+        if (op == '/' && rhs.min_value <= -1 && -1 <= rhs.max_value) {
+            others[2] = -1;
+        }
+        if (op == '/' && rhs.min_value <= 1 && 1 <= rhs.max_value) {
+            others[3] = 1;
+        }
+
+        VariableRange output = {INT_MAX, INT_MIN};
+        for (int first : bounds) {
+            for (int second : others) {
+                int result = combineBounds(first, second, op);
+                output.min_value = min(output.min_value, result);
+                output.max_value = max(output.max_value, result);
+            }
+        }
+        return output;
+    }
+
+    // ================== TIMING ================== //
+
+    // Ranges mostly small and around 0 like indices, some reaching up to the int bounds
+    vector<VariableRange> generateRanges(unsigned count, unsigned seed) {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<int> small(-1000, 1000);
+        std::uniform_int_distribution<int> any(INT_MIN, INT_MAX);
+        vector<VariableRange> ranges;
+        for (unsigned i = 0; i < count; ++i) {
+            int first = random() % 8 ? small(random) : any(random);
+            int second = random() % 8 ? small(random) : any(random);
+            ranges.push_back({min(first, second), max(first, second)});
+        }
+        return ranges;
+    }
+
+    // Nanoseconds per transfer of kernel over all pairs of neighbours in ranges, the fastest of
+    // repeats rounds. The bounds are summed into sink so the transfers cannot be left out.
+    template <typename Kernel>
+    double timeKernel(const vector<VariableRange>& ranges, unsigned repeats, Kernel kernel, long long& sink) {
+        double fastest = 0;
+        for (unsigned round = 0; round < repeats; ++round) {
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned i = 0; i + 1 < ranges.size(); ++i) {
+                VariableRange result = kernel(ranges[i], ranges[i + 1]);
+                sink += result.min_value ^ result.max_value;
+            }
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            double per_transfer = elapsed.count() / (ranges.size() - 1);
+            fastest = round == 0 ? per_transfer : min(fastest, per_transfer);
+        }
+        return fastest;
+    }
+
+    template <char Op>
+    void benchOperator(const vector<VariableRange>& ranges, unsigned repeats) {
+        long long sink = 0;
+        double combinations = timeKernel(ranges, repeats, [](const VariableRange& lhs, const VariableRange& rhs) {
+            return allCombinations(lhs, rhs, Op);
+        }, sink);
+        double kernel = timeKernel(ranges, repeats, IntervalKernel<Op>::apply, sink);
+
+        unsigned differ = 0;
+        for (unsigned i = 0; i + 1 < ranges.size(); ++i) {
+            differ += !(allCombinations(ranges[i], ranges[i + 1], Op) == IntervalKernel<Op>::apply(ranges[i], ranges[i + 1]));
+        }
+
+        printf("{\"operator\": \"%c\", \"all_combinations_ns\": %.3f, \"kernel_ns\": %.3f, \"speedup\": %.2f, "
+               "\"results_differ\": %u, \"sink\": %lld}\n", Op, combinations, kernel, combinations / kernel, differ,
+               sink & 1);
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned count = argc > 1 ? atoi(argv[1]) : 1000000;
+    unsigned repeats = argc > 2 ? atoi(argv[2]) : 5;
+    if (count < 2 || repeats < 1) {
+        fprintf(stderr, "usage: %s [ranges, at least 2] [repeats, at least 1]\n", argv[0]);
+        return 1;
+    }
+
+    vector<VariableRange> ranges = generateRanges(count, 0);
+    benchOperator<'+'>(ranges, repeats);
+    benchOperator<'-'>(ranges, repeats);
+    benchOperator<'*'>(ranges, repeats);
+    benchOperator<'/'>(ranges, repeats);
+    return 0;
+}
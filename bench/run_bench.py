@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+# Runs the bounds check pass over generated IR and prints one JSON object per line for each
+# configuration: its sizes, the mode of the analysis, the wall time, the solver iterations and the
+# peak resident memory of opt. Solver iterations are read from the statistics, they are null when
+# opt is built without them.
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+# Sizes of the generated functions, from small to large. Each entry only lists what differs from
+# the defaults of generate_ir.py.
+CONFIGURATIONS = [
+    {"blocks": 50, "locals": 5, "loop-depth": 1},
+    {"blocks": 200, "locals": 20, "loop-depth": 2},
+    {"blocks": 1000, "locals": 50, "loop-depth": 3},
+    {"blocks": 1000, "locals": 50, "loop-depth": 3, "switch-fanin": 16},
+    {"blocks": 1000, "locals": 50, "loop-depth": 3, "geps-per-block": 8},
+    {"blocks": 4000, "locals": 200, "loop-depth": 4},
+    {"functions": 50, "blocks": 100, "locals": 10, "loop-depth": 2},
+]
+
+# Passes run before the analysis in each mode. The IR is generated in memory form.
+MODES = {
+    "memory": [],
+    "ssa": ["-mem2reg"],
+}
+
+
+def generate(generator, configuration, path):
+    command = [sys.executable, generator, "-o", path]
+    for option, value in sorted(configuration.items()):
+        command += ["--" + option, str(value)]
+    subprocess.check_call(command)
+
+
+def run_opt(opt, plugin, passes, path, extra):
+    """Runs opt on path, returns its wall time in seconds, peak RSS in KiB and statistics."""
+    with tempfile.NamedTemporaryFile(suffix=".json") as stats:
+        command = [opt, "-load", plugin] + passes + ["-BoundsCheck", "-disable-output", "-stats",
+                   "-stats-json", "-info-output-file=" + stats.name] + extra + [path]
+
+        start = time.perf_counter()
+        process = subprocess.Popen(command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        _, status, usage = os.wait4(process.pid, 0)
+        elapsed = time.perf_counter() - start
+        if not os.WIFEXITED(status) or os.WEXITSTATUS(status) != 0:
+            raise RuntimeError("opt failed on " + path + ": " + " ".join(command))
+
+        try:
+            with open(stats.name) as contents:
+                statistics = json.load(contents)
+        except ValueError:
+            statistics = {}
+
+    return elapsed, usage.ru_maxrss, statistics
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmarks the bounds check pass")
+    parser.add_argument("--opt", required=True, help="opt binary to run")
+    parser.add_argument("--plugin", required=True, help="the LLVMJPT plugin")
+    parser.add_argument("--generator", default=os.path.join(os.path.dirname(__file__), "generate_ir.py"))
+    parser.add_argument("--repeat", type=int, default=3, help="runs of each configuration, the fastest counts")
+    parser.add_argument("--output", default="-", help="file for the JSON lines, - for stdout")
+    parser.add_argument("extra", nargs="*", help="further options for opt, after --")
+    args = parser.parse_args()
+
+    output = sys.stdout if args.output == "-" else open(args.output, "w")
+    with tempfile.TemporaryDirectory() as directory:
+        for number, configuration in enumerate(CONFIGURATIONS):
+            path = os.path.join(directory, "bench{}.ll".format(number))
+            generate(args.generator, configuration, path)
+
+            for mode, passes in sorted(MODES.items()):
+                runs = [run_opt(args.opt, args.plugin, passes, path, args.extra) for _ in range(args.repeat)]
+                elapsed = min(run[0] for run in runs)
+                peak = max(run[1] for run in runs)
+                statistics = runs[0][2]
+
+                record = {"configuration": configuration, "mode": mode, "seconds": round(elapsed, 6),
+                          "solver_iterations": statistics.get("bounds-check.NumSolverIterations"),
+                          "peak_rss_kib": peak}
+                output.write(json.dumps(record, sort_keys=True) + "\n")
+                output.flush()
+
+    if output is not sys.stdout:
+        output.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,23 @@
+#ifndef RUNTIME_CHECKS_H
+#define RUNTIME_CHECKS_H
+
+// Indexing for the runtime benchmarks. Built with -DCHECKED, every index is checked against the
+// size of its array before the access, like std::vector::at does, and a failing check aborts.
+// Otherwise the index is used as it is. The index is evaluated twice, it has no side effects.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef CHECKED
+#define AT(index, size) ((unsigned) (index) < (unsigned) (size) ? (index) : (abort(), 0))
+#else
+#define AT(index, size) (index)
+#endif
+
+// Pseudo random numbers without calling into the C library, the same on every platform
+static inline unsigned nextRandom(unsigned* state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+#endif
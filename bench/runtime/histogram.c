@@ -0,0 +1,38 @@
+// Counts bytes into 256 bins and into 10 coarser ones. The bins come from the values, which
+// are bytes, so only their range keeps the bins in bounds.
+
+#include "checks.h"
+
+#define SIZE (1 << 20)
+#define ROUNDS 200
+#define COARSE 10
+
+static unsigned char data[SIZE];
+static int bins[256];
+static int coarse[COARSE];
+
+int main() {
+    unsigned state = 1;
+    for (int i = 0; i < SIZE; ++i) {
+        data[AT(i, SIZE)] = nextRandom(&state);
+    }
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i < SIZE; ++i) {
+            int value = data[AT(i, SIZE)];
+            bins[AT(value, 256)] += 1;
+            coarse[AT(value * COARSE / 256, COARSE)] += 1;
+        }
+    }
+
+    long long sum = 0;
+    for (int i = 0; i < 256; ++i) {
+        sum += (long long) bins[AT(i, 256)] * i;
+    }
+    for (int i = 0; i < COARSE; ++i) {
+        sum += (long long) coarse[AT(i, COARSE)] * i;
+    }
+
+    printf("%lld\n", sum);
+    return 0;
+}
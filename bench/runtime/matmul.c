@@ -0,0 +1,38 @@
+// Multiplies two square matrices in the i, k, j order, every index is a loop counter.
+
+#include "checks.h"
+
+#define N 768
+
+static int a[N][N];
+static int b[N][N];
+static int c[N][N];
+
+int main() {
+    unsigned state = 1;
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < N; ++j) {
+            a[AT(i, N)][AT(j, N)] = nextRandom(&state) % 100;
+            b[AT(i, N)][AT(j, N)] = nextRandom(&state) % 100;
+        }
+    }
+
+    for (int i = 0; i < N; ++i) {
+        for (int k = 0; k < N; ++k) {
+            int scale = a[AT(i, N)][AT(k, N)];
+            for (int j = 0; j < N; ++j) {
+                c[AT(i, N)][AT(j, N)] += scale * b[AT(k, N)][AT(j, N)];
+            }
+        }
+    }
+
+    long long sum = 0;
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < N; ++j) {
+            sum += c[AT(i, N)][AT(j, N)];
+        }
+    }
+
+    printf("%lld\n", sum);
+    return 0;
+}
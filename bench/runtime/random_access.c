@@ -0,0 +1,25 @@
+// Reads and writes a table at random indices, like the std::vector::at benchmark of
+// paperNumbers. rand() % SIZE is always in bounds, but only if rand() is known not to be negative.
+
+#include "checks.h"
+
+#define SIZE (1 << 22)
+#define ITERATIONS 10000000
+
+static int table[SIZE];
+
+int main() {
+    for (int i = 0; i < ITERATIONS; ++i) {
+        int index = rand() % SIZE;
+        table[AT(index, SIZE)] = i;
+    }
+
+    long long sum = 0;
+    for (int i = 0; i < ITERATIONS; ++i) {
+        int index = rand() % SIZE;
+        sum += table[AT(index, SIZE)];
+    }
+
+    printf("%lld\n", sum);
+    return 0;
+}
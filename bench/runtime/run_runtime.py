@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+# Times the runtime kernels in their three builds and writes a CSV row for each: the median wall
+# time and its variance over the timed runs, the slowdown against the build without checks, and
+# for the build of the pass how much of the cost of the naive checks it recovers. The runs before
+# are only to warm up the caches. Every build of a kernel has to print the same result.
+
+import argparse
+import csv
+import os
+import statistics
+import subprocess
+import sys
+import time
+
+KERNELS = ["random_access", "stencil", "matmul", "histogram", "string_scan"]
+
+# Without checks, with a check before every access, and with what the pass left of them
+VARIANTS = ["unchecked", "naive", "pass"]
+
+
+def run(path):
+    """Runs path once, returns its wall time in seconds and what it printed."""
+    start = time.perf_counter()
+    process = subprocess.run([path], stdout=subprocess.PIPE, universal_newlines=True)
+    elapsed = time.perf_counter() - start
+    if process.returncode != 0:
+        raise RuntimeError(path + " failed with status " + str(process.returncode))
+    return elapsed, process.stdout
+
+
+def measure(path, warmup, repeat):
+    for _ in range(warmup):
+        run(path)
+    runs = [run(path) for _ in range(repeat)]
+    outputs = set(output for _, output in runs)
+    if len(outputs) != 1:
+        raise RuntimeError(path + " printed different results")
+    return [elapsed for elapsed, _ in runs], outputs.pop()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Times the bounds checks at runtime")
+    parser.add_argument("--directory", required=True, help="where the builds are, as <kernel>_<variant>")
+    parser.add_argument("--kernels", nargs="+", default=KERNELS)
+    parser.add_argument("--warmup", type=int, default=2, help="runs of each build before timing it")
+    parser.add_argument("--repeat", type=int, default=10, help="timed runs of each build, at least 2")
+    parser.add_argument("--output", default="-", help="file for the CSV, - for stdout")
+    args = parser.parse_args()
+    if args.repeat < 2:
+        parser.error("--repeat needs at least 2 runs for a variance")
+
+    output = sys.stdout if args.output == "-" else open(args.output, "w", newline="")
+    writer = csv.writer(output)
+    writer.writerow(["kernel", "variant", "runs", "median_seconds", "variance", "slowdown", "recovered"])
+
+    for kernel in args.kernels:
+        medians = {}
+        result = None
+        for variant in VARIANTS:
+            path = os.path.join(args.directory, kernel + "_" + variant)
+            times, printed = measure(path, args.warmup, args.repeat)
+            if result is not None and printed != result:
+                raise RuntimeError(path + " printed another result than " + kernel + "_unchecked")
+            result = printed
+            medians[variant] = statistics.median(times)
+
+            slowdown = medians[variant] / medians["unchecked"]
+
+            # The share of the cost of the naive checks the pass removed, none if they cost nothing
+            recovered = ""
+            cost = medians["naive"] - medians["unchecked"] if "naive" in medians else 0
+            if variant == "pass" and cost > 0:
+                recovered = "{:.3f}".format((medians["naive"] - medians["pass"]) / cost)
+
+            writer.writerow([kernel, variant, len(times), "{:.6f}".format(medians[variant]),
+                             "{:.3e}".format(statistics.variance(times)), "{:.3f}".format(slowdown), recovered])
+            output.flush()
+
+    if output is not sys.stdout:
+        output.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,44 @@
+// A 5-point stencil over a grid kept in one flat array, so the neighbours above and below are
+// COLS apart. The interior rows and columns keep every neighbour in bounds.
+
+#include "checks.h"
+
+#define ROWS 512
+#define COLS 512
+#define CELLS (ROWS * COLS)
+#define STEPS 400
+
+static int grid[CELLS];
+static int next[CELLS];
+
+// One step from src to dst, only the interior changes
+#define SWEEP(src, dst)                                                                       \
+    for (int y = 1; y < ROWS - 1; ++y) {                                                      \
+        for (int x = 1; x < COLS - 1; ++x) {                                                  \
+            int cell = y * COLS + x;                                                          \
+            dst[AT(cell, CELLS)] = (src[AT(cell, CELLS)] + src[AT(cell - 1, CELLS)] +         \
+                                    src[AT(cell + 1, CELLS)] + src[AT(cell - COLS, CELLS)] +  \
+                                    src[AT(cell + COLS, CELLS)]) / 5;                         \
+        }                                                                                     \
+    }
+
+int main() {
+    unsigned state = 1;
+    for (int i = 0; i < CELLS; ++i) {
+        grid[AT(i, CELLS)] = nextRandom(&state) % 1000;
+        next[AT(i, CELLS)] = grid[AT(i, CELLS)];
+    }
+
+    for (int step = 0; step < STEPS; step += 2) {
+        SWEEP(grid, next)
+        SWEEP(next, grid)
+    }
+
+    long long sum = 0;
+    for (int i = 0; i < CELLS; ++i) {
+        sum += grid[AT(i, CELLS)];
+    }
+
+    printf("%lld\n", sum);
+    return 0;
+}
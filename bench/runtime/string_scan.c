@@ -0,0 +1,40 @@
+// Scans a text for a pattern at every position and counts the letters of each kind. The pattern
+// never reaches past the text since the scan stops PATTERN before its end.
+
+#include "checks.h"
+
+#define SIZE (1 << 20)
+#define PATTERN 4
+#define ROUNDS 60
+
+static char text[SIZE];
+static char pattern[PATTERN] = {'a', 'b', 'a', 'c'};
+static int vowels[128];
+static int kinds[2];
+
+int main() {
+    unsigned state = 1;
+    for (int i = 0; i < SIZE; ++i) {
+        text[AT(i, SIZE)] = 'a' + nextRandom(&state) % 4;
+    }
+    vowels['a'] = 1;
+
+    long long matches = 0;
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 0; i + PATTERN <= SIZE; ++i) {
+            int j = 0;
+            while (j < PATTERN && text[AT(i + j, SIZE)] == pattern[AT(j, PATTERN)]) {
+                ++j;
+            }
+            matches += j == PATTERN;
+        }
+
+        for (int i = 0; i < SIZE; ++i) {
+            int letter = text[AT(i, SIZE)] & 127;
+            kinds[AT(vowels[AT(letter, 128)], 2)] += 1;
+        }
+    }
+
+    printf("%lld %d %d\n", matches, kinds[0], kinds[1]);
+    return 0;
+}
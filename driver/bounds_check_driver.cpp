@@ -0,0 +1,245 @@
+// LLVM Includes
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+
+// Personal Includes
+#include "BoundsCheck.h"
+
+// STL includes
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// usings
+using namespace llvm;
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+/*
+ * Description:
+ * Checks the bounds of many bitcode files in one process. Every file is read into an LLVMContext
+ * of its own, so the files are checked on all threads at once, and the process and the analysis
+ * only start once instead of once per file. The warnings of each file are printed together, in
+ * the order the files were given, followed by the counts of each file and their total. With
+ * -bounds-check-format=jsonl or sarif, the records of all files form one output.
+ *
+ * bounds-check-driver [options] file.bc... [-manifest compile_commands.json]
+ *
+ * Every option of the pass applies, -BoundsCheck-eliminate/-guard/-annotate only change the
+ * modules in memory.
+ */
+
+static cl::list<std::string> InputFiles(cl::Positional, cl::desc("<bitcode files>"), cl::ZeroOrMore);
+
+static cl::opt<std::string> Manifest(
+    "manifest", cl::desc("compile_commands.json style list of the files to check, the bitcode of an entry "
+                         "is its \"output\", or its \"file\" with a .bc extension"),
+    cl::value_desc("filename"));
+
+static cl::opt<std::string> OutputFilename(
+    "o", cl::desc("Where the results go, - for stdout"), cl::value_desc("filename"), cl::init("-"));
+
+static cl::opt<unsigned> Jobs(
+    "j", cl::desc("Files checked at the same time, 0 for one per core"), cl::init(0));
+
+static cl::opt<bool> Interprocedural(
+    "interprocedural", cl::desc("Check every module like -BoundsCheck-module"));
+
+// What checking one file found
+struct FileResult {
+    string output;
+    BoundsCheckReport::Counts counts;
+    bool failed = false;
+};
+
+/*
+ * Description:
+ * Adds the bitcode files of the entries of the manifest at path to files. Returns false with an
+ * error printed if it cannot be read.
+ */
+static bool readManifest(StringRef path, vector<string>& files) {
+    ErrorOr<unique_ptr<MemoryBuffer> > buffer = MemoryBuffer::getFile(path);
+    if (!buffer) {
+        errs() << path << ": " << buffer.getError().message() << "\n";
+        return false;
+    }
+
+    Expected<json::Value> manifest = json::parse((*buffer)->getBuffer());
+    if (!manifest) {
+        errs() << path << ": " << toString(manifest.takeError()) << "\n";
+        return false;
+    }
+
+    const json::Array* entries = manifest->getAsArray();
+    if (!entries) {
+        errs() << path << ": expected an array of compile commands\n";
+        return false;
+    }
+
+    for (const json::Value& value : *entries) {
+        const json::Object* entry = value.getAsObject();
+        if (!entry) {
+            errs() << path << ": expected an object for every compile command\n";
+            return false;
+        }
+
+        SmallString<128> file;
+        if (auto output = entry->getString("output")) {
+            file = *output;
+        }
+        else if (auto source = entry->getString("file")) {
+            file = *source;
+            sys::path::replace_extension(file, "bc");
+        }
+        else {
+            errs() << path << ": compile command without a file\n";
+            return false;
+        }
+
+        auto directory = entry->getString("directory");
+        if (directory && sys::path::is_relative(file)) {
+            SmallString<128> absolute(*directory);
+            sys::path::append(absolute, file);
+            file = absolute;
+        }
+        files.push_back(string(file.str()));
+    }
+    return true;
+}
+
+/*
+ * Description:
+ * Reads and checks the file at path, everything printed goes to result.
+ */
+static void checkFile(const string& path, FileResult& result) {
+    raw_string_ostream os(result.output);
+    LLVMContext context;
+    SMDiagnostic error;
+    unique_ptr<Module> module = parseIRFile(path, error, context);
+    if (!module) {
+        error.print("bounds-check-driver", os);
+        result.failed = true;
+        return;
+    }
+
+    BoundsCheckReport report(os, getReportFormat());
+    checkModuleBounds(*module, Interprocedural, report);
+    result.counts = report.getCounts();
+}
+
+/*
+ * Description:
+ * Prints the counts of one file, or of all of them, under name. The structured formats already
+ * hold a summary of every file, only the total is added to JSON Lines.
+ */
+static void printCounts(raw_ostream& os, StringRef name, const BoundsCheckReport::Counts& counts,
+                        bool total) {
+    BoundsCheckReport::Format format = getReportFormat();
+    if (format == BoundsCheckReport::FORMAT_TEXT) {
+        os << name << ": " << counts.num_functions << " functions, " << counts.num_proven_safe
+           << " accesses proven safe, " << counts.num_unproven << " unproven, " << counts.num_out_of_bounds
+           << " out of bounds, " << counts.num_given_up << " functions given up.\n";
+    }
+    else if (format == BoundsCheckReport::FORMAT_JSON_LINES && total) {
+        os << "{\"type\":\"total\",\"functions\":" << counts.num_functions << ",\"proven_safe\":"
+           << counts.num_proven_safe << ",\"unproven\":" << counts.num_unproven << ",\"out_of_bounds\":"
+           << counts.num_out_of_bounds << ",\"given_up\":" << counts.num_given_up << "}\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    InitLLVM init(argc, argv);
+    cl::ParseCommandLineOptions(argc, argv, "Bounds check driver\n");
+
+    vector<string> files(InputFiles.begin(), InputFiles.end());
+    if (!Manifest.empty() && !readManifest(Manifest, files)) {
+        return 1;
+    }
+    if (files.empty()) {
+        errs() << argv[0] << ": no input files\n";
+        return 1;
+    }
+
+    std::error_code error;
+#if LLVM_VERSION_MAJOR >= 10
+    raw_fd_ostream output(OutputFilename, error, sys::fs::OF_Text);
+#else
+    raw_fd_ostream output(OutputFilename, error, sys::fs::F_Text);
+#endif
+    if (error) {
+        errs() << OutputFilename << ": " << error.message() << "\n";
+        return 1;
+    }
+
+    // The timers of the phases are not meant to run on several threads
+    unsigned jobs = Jobs ? Jobs : std::thread::hardware_concurrency();
+    if (jobs > 1) {
+        TimePassesIsEnabled = false;
+    }
+    initializeBoundsCheck();
+
+    vector<FileResult> results(files.size());
+    {
+#if LLVM_VERSION_MAJOR >= 10
+        ThreadPool pool(hardware_concurrency(jobs));
+#else
+        ThreadPool pool(std::max(jobs, 1u));
+#endif
+        for (size_t i = 0; i < files.size(); ++i) {
+            pool.async([&files, &results, i] { checkFile(files[i], results[i]); });
+        }
+        pool.wait();
+    }
+
+    // Every file is one run of the SARIF log, files that could not be read are left out
+    bool sarif = getReportFormat() == BoundsCheckReport::FORMAT_SARIF;
+    if (sarif) {
+        BoundsCheckReport::beginSARIF(output);
+    }
+
+    BoundsCheckReport::Counts total;
+    unsigned failed = 0;
+    bool first_run = true;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (results[i].failed) {
+            errs() << results[i].output;
+            ++failed;
+            continue;
+        }
+
+        if (sarif && !first_run) {
+            output << ",\n";
+        }
+        first_run = false;
+        output << results[i].output;
+        printCounts(output, files[i], results[i].counts, false);
+        total += results[i].counts;
+    }
+
+    printCounts(output, "total", total, true);
+    if (sarif) {
+        BoundsCheckReport::endSARIF(output);
+    }
+    if (failed) {
+        errs() << failed << " of " << files.size() << " files could not be read.\n";
+    }
+    return failed ? 1 : 0;
+}
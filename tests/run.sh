@@ -8,7 +8,78 @@ for filename in test*.c; do
     /home/bingscha/bin/bin/clang -emit-llvm -c -g ${filename} -o test.bc
 
     /home/bingscha/bin/bin/opt -load ${PATH_MYPASS} ${NAME_MYPASS} -disable-output < test.bc
+
+    # Same test after mem2reg, exercises the SSA mode of the pass
+    /home/bingscha/bin/bin/clang -emit-llvm -c -g -Xclang -disable-O0-optnone ${filename} -o test.bc
+
+    /home/bingscha/bin/bin/opt -load ${PATH_MYPASS} -mem2reg ${NAME_MYPASS} -disable-output < test.bc
+done
+
+# Removes the guards proven to never fail, prints how many were removed
+for filename in test_eliminate*.c; do
+    /home/bingscha/bin/bin/clang -emit-llvm -c -g -Xclang -disable-O0-optnone ${filename} -o test.bc
+
+    /home/bingscha/bin/bin/opt -load ${PATH_MYPASS} -mem2reg ${NAME_MYPASS} -BoundsCheck-eliminate -disable-output < test.bc
+done
+
+# The std::vector of paperNumbers after inlining, both at() checks are removed
+/home/bingscha/bin/bin/opt -load ${PATH_MYPASS} ${NAME_MYPASS} -BoundsCheck-eliminate -disable-output < test_heap_vector.ll
+
+# Guards the accesses that are not proven in bounds, prints the counts per function
+for filename in test_guard*.c; do
+    /home/bingscha/bin/bin/clang -emit-llvm -c -g -Xclang -disable-O0-optnone ${filename} -o test.bc
+
+    /home/bingscha/bin/bin/opt -load ${PATH_MYPASS} -mem2reg ${NAME_MYPASS} -BoundsCheck-guard -verify -disable-output < test.bc
+done
+
+# Same with block frequencies, only the guards of hot loops are hoisted
+for filename in test_guard*.c; do
+    /home/bingscha/bin/bin/clang -emit-llvm -c -g -Xclang -disable-O0-optnone ${filename} -o test.bc
+
+    /home/bingscha/bin/bin/opt -load ${PATH_MYPASS} -mem2reg ${NAME_MYPASS} -BoundsCheck-guard -BoundsCheck-profile -verify -disable-output < test.bc
+done
+
+# Bounds calls by the summaries of their callees and arguments by their call sites
+for filename in test_interprocedural*.c; do
+    /home/bingscha/bin/bin/clang -emit-llvm -c -g ${filename} -o test.bc
+
+    /home/bingscha/bin/bin/opt -load ${PATH_MYPASS} ${NAME_MYPASS}-module -BoundsCheck-guard -verify -disable-output < test.bc
+
+    /home/bingscha/bin/bin/clang -emit-llvm -c -g -Xclang -disable-O0-optnone ${filename} -o test.bc
+
+    /home/bingscha/bin/bin/opt -load ${PATH_MYPASS} -mem2reg ${NAME_MYPASS}-module -BoundsCheck-guard -verify -disable-output < test.bc
+done
+
+# Proves the accesses bounded by other variables with the differences between them
+for filename in test_relational*.c; do
+    /home/bingscha/bin/bin/clang -emit-llvm -c -g ${filename} -o test.bc
+
+    /home/bingscha/bin/bin/opt -load ${PATH_MYPASS} ${NAME_MYPASS} -BoundsCheck-relational -stats -disable-output < test.bc
+
+    /home/bingscha/bin/bin/clang -emit-llvm -c -g -Xclang -disable-O0-optnone ${filename} -o test.bc
+
+    /home/bingscha/bin/bin/opt -load ${PATH_MYPASS} -mem2reg ${NAME_MYPASS} -BoundsCheck-relational -stats -disable-output < test.bc
+done
+
+# Only tracks what the indices depend on, -stats counts the functions skipped
+for filename in test_demand_driven*.c; do
+    /home/bingscha/bin/bin/clang -emit-llvm -c -g ${filename} -o test.bc
+
+    /home/bingscha/bin/bin/opt -load ${PATH_MYPASS} ${NAME_MYPASS} -bounds-check-demand-driven -stats -disable-output < test.bc
+
+    /home/bingscha/bin/bin/clang -emit-llvm -c -g -Xclang -disable-O0-optnone ${filename} -o test.bc
+
+    /home/bingscha/bin/bin/opt -load ${PATH_MYPASS} -mem2reg ${NAME_MYPASS} -bounds-check-demand-driven -stats -disable-output < test.bc
 done
 
 rm test.bc
-# Apply your pass to bitcode (IR)
+
+# All tests in one process, prints the counts of each file and their total
+for filename in test*.c; do
+    /home/bingscha/bin/bin/clang -emit-llvm -c -g ${filename} -o ${filename%.c}.bc
+done
+
+/home/bingscha/eecs590Project/build/driver/bounds-check-driver test*.bc
+rm -f test*.bc
+
+# Apply your pass to bitcode (IR)
\ No newline at end of file
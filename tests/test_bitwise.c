@@ -0,0 +1,18 @@
+#define SIZE 16
+
+int main(int argc, char** argv) {
+    int table[SIZE];
+
+    // In bounds, the mask keeps the index in [0, 15]
+    int masked = argc & (SIZE - 1);
+    table[masked] = 1;
+
+    // In bounds, (masked >> 1) << 1 is at most 14 and masked / 2 at most 7
+    table[(masked >> 1) << 1] = 2;
+    table[(unsigned) masked / 2u] = 3;
+
+    // Out of bounds, or-ing in 16 makes the index at least 16
+    table[masked | SIZE] = 4;
+
+    return table[0];
+}
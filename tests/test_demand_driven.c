@@ -0,0 +1,24 @@
+#define SIZE 20
+
+// No array access, skipped with -bounds-check-demand-driven
+int checksum(int seed, int rounds) {
+    int hash = seed;
+    for (int i = 0; i < rounds; ++i) {
+        hash = hash * 31 + i;
+    }
+    return hash;
+}
+
+int main(int argc, char** argv) {
+    int values[SIZE];
+
+    // Not in the slice of any index, never tracked with -bounds-check-demand-driven
+    int total = checksum(argc, 100);
+
+    // In bounds, i and its compare are all the slice holds
+    for (int i = 0; i < SIZE; ++i) {
+        values[i] = total;
+    }
+
+    return values[SIZE - 1];
+}
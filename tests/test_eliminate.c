@@ -0,0 +1,29 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+int main() {
+    int array[30];
+
+    // Always in bounds, the guard can be removed
+    for (int i = 0; i < 30; ++i) {
+        if (i >= 30) {
+            abort();
+        }
+        array[i] = i;
+    }
+
+    // Guard on an index that can be out of bounds, has to stay
+    int j = rand();
+    if (j >= 30 || j < 0) {
+        abort();
+    }
+
+    // scanf may write anything to k, the guard has to stay
+    int k = 5;
+    scanf("%d", &k);
+    if (k >= 30 || k < 0) {
+        abort();
+    }
+
+    return array[j] + array[k];
+}
@@ -0,0 +1,27 @@
+#include <stdlib.h>
+
+int main() {
+    int array[4];
+    int values[10];
+    for (int i = 0; i < 10; ++i) {
+        values[i] = rand();
+    }
+
+    // Counts up to 10 through a compare, the guard has to stay
+    int count = 0;
+    for (int i = 0; i < 10; ++i) {
+        count += values[i] > 0;
+    }
+    if (count >= 4) {
+        abort();
+    }
+    array[count] = 1;
+
+    // Out of bounds once the flag is set, the access is reached
+    int flag = values[0] < values[1];
+    if (flag) {
+        array[9] = 2;
+    }
+
+    return array[0];
+}
@@ -0,0 +1,24 @@
+#include <stdlib.h>
+
+int main() {
+    int array[100];
+
+    // Proven in bounds, no guard
+    for (int i = 0; i < 100; ++i) {
+        array[i] = i;
+    }
+
+    // Not known, guarded
+    int j = rand();
+    array[j] = 0;
+
+    // Affine in the loop, checked once before it and the loop is versioned
+    int n = rand();
+    for (int i = 0; i < n; ++i) {
+        array[i] += i;
+    }
+
+    // Always out of bounds, guarded and reported
+    int k = 100;
+    return array[k];
+}
@@ -0,0 +1,21 @@
+#include <stdlib.h>
+
+#define SIZE 100
+
+int main() {
+    int* values = malloc(SIZE * sizeof(int));
+
+    // In bounds, the loop stays below the size malloc was given
+    for (int i = 0; i < SIZE; ++i) {
+        values[i] = i;
+    }
+
+    // In bounds, rand() is never negative so the remainder is in [0, SIZE - 1]
+    int sum = values[rand() % SIZE];
+
+    // Out of bounds, one past the end of the allocation
+    sum += values[SIZE];
+
+    free(values);
+    return sum;
+}
@@ -0,0 +1,56 @@
+; paperNumbers/withRangeChecking.c reduced after clang++ -O2: the vector is inlined, its data is the
+; operator new call and at() compares the index against the constant size. Both checks can go.
+declare noalias nonnull i8* @_Znwm(i64)
+declare void @_ZdlPv(i8*)
+declare i32 @rand()
+declare void @_ZSt24__throw_out_of_range_fmtPKcz(i8*, ...) noreturn
+
+define i32 @main() {
+entry:
+  %call = call noalias nonnull i8* @_Znwm(i64 400000000)
+  %data = bitcast i8* %call to i32*
+  br label %store_loop
+
+store_loop:
+  %i = phi i32 [ 0, %entry ], [ %store_inc, %store_ok ]
+  %r = call i32 @rand()
+  %rem = srem i32 %r, 100000000
+  %idx = sext i32 %rem to i64
+  %bad = icmp ugt i64 %idx, 99999999
+  br i1 %bad, label %throw, label %store_ok
+
+store_ok:
+  %value = call i32 @rand()
+  %el = getelementptr inbounds i32, i32* %data, i64 %idx
+  store i32 %value, i32* %el
+  %store_inc = add nuw nsw i32 %i, 1
+  %store_done = icmp eq i32 %store_inc, 100000000
+  br i1 %store_done, label %load_loop, label %store_loop
+
+load_loop:
+  %j = phi i32 [ 0, %store_ok ], [ %load_inc, %load_ok ]
+  %sum = phi i64 [ 0, %store_ok ], [ %sum_next, %load_ok ]
+  %r2 = call i32 @rand()
+  %rem2 = srem i32 %r2, 100000000
+  %idx2 = sext i32 %rem2 to i64
+  %bad2 = icmp ugt i64 %idx2, 99999999
+  br i1 %bad2, label %throw, label %load_ok
+
+load_ok:
+  %el2 = getelementptr inbounds i32, i32* %data, i64 %idx2
+  %loaded = load i32, i32* %el2
+  %wide = sext i32 %loaded to i64
+  %sum_next = add nsw i64 %sum, %wide
+  %load_inc = add nuw nsw i32 %j, 1
+  %load_done = icmp eq i32 %load_inc, 100000000
+  br i1 %load_done, label %exit, label %load_loop
+
+throw:
+  call void (i8*, ...) @_ZSt24__throw_out_of_range_fmtPKcz(i8* null, i64 0, i64 100000000)
+  unreachable
+
+exit:
+  call void @_ZdlPv(i8* %call)
+  %result = trunc i64 %sum_next to i32
+  ret i32 %result
+}
@@ -0,0 +1,36 @@
+#include <stdlib.h>
+
+// Only in bounds for the indices main passes
+static int get(int index) {
+    int array[10];
+    for (int i = 0; i < 10; ++i) {
+        array[i] = i;
+    }
+    return array[index];
+}
+
+// Always returns an index in [0, 9]
+static int clamp(int index) {
+    if (index < 0) {
+        return 0;
+    }
+    if (index > 9) {
+        return 9;
+    }
+    return index;
+}
+
+// Out of bounds, the summary of clamp bounds the returned index to [10, 19]
+static int past(int index) {
+    int array[10];
+    array[0] = 0;
+    return array[clamp(index) + 10];
+}
+
+int main() {
+    int sum = 0;
+    for (int i = 0; i < 5; ++i) {
+        sum += get(i);
+    }
+    return sum + get(clamp(rand())) + past(rand());
+}
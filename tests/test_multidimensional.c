@@ -0,0 +1,38 @@
+#include <stdint.h>
+
+#define HEIGHT 10
+#define WIDTH 20
+
+// A lookup table, checked like a local array
+static const uint8_t table[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+struct histogram {
+    int total;
+    double bins[8];
+};
+
+int main() {
+    uint8_t image[HEIGHT][WIDTH];
+    struct histogram counts = {0};
+
+    // In bounds, every dimension stays below its size
+    for (int y = 0; y < HEIGHT; ++y) {
+        for (int x = 0; x < WIDTH; ++x) {
+            image[y][x] = table[(x + y) % 16];
+        }
+    }
+
+    // In bounds, an array within a struct
+    for (int i = 0; i < 8; ++i) {
+        counts.bins[i] = image[i][i];
+    }
+
+    // Out of bounds, the row is in bounds but the column is one past the end
+    int sum = image[HEIGHT - 1][WIDTH];
+
+    // Out of bounds, the bins hold elements of 8 bytes, not 4
+    sum += counts.bins[8];
+
+    // Out of bounds, one past the end of the table
+    return sum + table[16];
+}
@@ -0,0 +1,27 @@
+#define SIZE 30
+
+int main(int argc, char** argv) {
+    int values[SIZE];
+    int n = argc;
+    if (n > SIZE) {
+        return 0;
+    }
+
+    // In bounds with -BoundsCheck-relational, i + 1 < n and n <= SIZE
+    for (int i = 0; i + 1 < n; ++i) {
+        values[i + 1] = i;
+    }
+
+    // In bounds with -BoundsCheck-relational, i < n keeps n - 1 - i from going negative
+    int sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += values[n - 1 - i];
+    }
+
+    // Not proven, i < n allows i = SIZE
+    for (int i = 0; i < n + 1; ++i) {
+        sum += values[i];
+    }
+
+    return sum;
+}
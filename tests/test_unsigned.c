@@ -0,0 +1,25 @@
+#include <stddef.h>
+
+#define SIZE 100
+
+int main(int argc, char** argv) {
+    int values[SIZE];
+
+    // In bounds, a size_t index below the size
+    for (size_t i = 0; i < SIZE; ++i) {
+        values[i] = i;
+    }
+
+    // In bounds, a negative argc would be a large unsigned value and fail the compare
+    int sum = 0;
+    if ((unsigned) argc < SIZE) {
+        sum += values[argc];
+    }
+
+    // Not proven, a negative argc turns into a large unsigned index
+    if (argc > -5 && argc < 50) {
+        sum += values[(unsigned) argc];
+    }
+
+    return sum;
+}
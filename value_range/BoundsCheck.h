@@ -0,0 +1,135 @@
+#ifndef BOUNDS_CHECK_H
+#define BOUNDS_CHECK_H
+
+// LLVM Includes
+#include "llvm/ADT/Optional.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+
+// STL Includes
+#include <string>
+#include <vector>
+
+// usings
+using namespace llvm;
+
+// An array access that is not proven in bounds, as it is reported
+struct BoundsCheckFinding {
+    const Instruction* access = nullptr;
+
+    // Source position of the access, no line if it has no debug information
+    std::string file;
+    unsigned line = 0;
+    unsigned column = 0;
+
+    // Name of the array in the source, or of its value without debug information
+    std::string array;
+    int array_size = 0;
+
+    // The range the index was found to have
+    int index_min = 0;
+    int index_max = 0;
+
+    // Always out of bounds, otherwise only not proven in bounds
+    bool out_of_bounds = false;
+
+    // Estimated times the access runs, from the profile or per call of its function. Only known
+    // with -BoundsCheck-profile, the findings of a function are then ranked by it.
+    Optional<uint64_t> execution_count;
+};
+
+// Where the findings of the analysis go: the warnings, and the number of accesses checked in every
+// function reported. The text format prints the warnings the passes always printed, the other
+// formats a record for every access not proven in bounds and a summary of every module.
+class BoundsCheckReport {
+public:
+    enum Format {
+        FORMAT_TEXT,
+        FORMAT_JSON_LINES,
+        FORMAT_SARIF
+    };
+
+    // What was found in the functions reported so far
+    struct Counts {
+        unsigned num_functions = 0;
+        unsigned num_proven_safe = 0;
+        unsigned num_unproven = 0;
+        unsigned num_out_of_bounds = 0;
+        unsigned num_given_up = 0;
+
+        Counts& operator+=(const Counts& other) {
+            num_functions += other.num_functions;
+            num_proven_safe += other.num_proven_safe;
+            num_unproven += other.num_unproven;
+            num_out_of_bounds += other.num_out_of_bounds;
+            num_given_up += other.num_given_up;
+            return *this;
+        }
+    };
+
+    explicit BoundsCheckReport(raw_ostream& os, Format format = FORMAT_TEXT) : os(os), format(format) {}
+
+    // Ends the last module, the stream has to outlive the report
+    ~BoundsCheckReport();
+
+    raw_ostream& getStream() {
+        return os;
+    }
+
+    Format getFormat() const {
+        return format;
+    }
+
+    // Starts reporting the module named name, the module before is finished first. Nothing
+    // happens if it is the module being reported already.
+    void beginModule(StringRef name);
+
+    // Reports the findings and counts of F, within the module of F
+    void addFunction(const Function& F, const Counts& function, const std::vector<BoundsCheckFinding>& findings);
+
+    // Writes the summary of the module reported so far, if there is one. In SARIF, every module
+    // is a run of its own.
+    void finishModule();
+
+    // Over all functions reported
+    const Counts& getCounts() const {
+        return counts;
+    }
+
+    // SARIF runs only form a file within its top level object. Whoever writes the file writes
+    // these around the runs, with a comma between two runs.
+    static void beginSARIF(raw_ostream& os);
+    static void endSARIF(raw_ostream& os);
+
+private:
+    void writeFinding(const Function& F, const BoundsCheckFinding& finding);
+    void writeSummary();
+
+    raw_ostream& os;
+    Format format;
+    Counts counts;
+
+    // The module being reported, and what was found in it so far
+    std::string module;
+    bool in_module = false;
+    Counts module_counts;
+    bool first_result = true;
+    unsigned num_modules = 0;
+};
+
+// Applies the options of the command line to the analysis. Call it once after parsing them and
+// before checking any module.
+void initializeBoundsCheck();
+
+// The format -bounds-check-format selects
+BoundsCheckReport::Format getReportFormat();
+
+// Checks every function of M like -BoundsCheck does, or like -BoundsCheck-module if
+// interprocedural is set, and applies the transforms selected on the command line. Everything
+// found goes to report, and M is its last module once this returns. Returns true if M changed.
+// Modules of different LLVMContexts can be checked on different threads at the same time.
+bool checkModuleBounds(Module& M, bool interprocedural, BoundsCheckReport& report);
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef RANGE_KERNELS_H
+#define RANGE_KERNELS_H
+
+// STL Includes
+#include <limits.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RANGE_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// Number of intervals the kernels work on at once, the bounds of one chunk
+#define RANGE_KERNEL_WIDTH 64
+
+// The instruction sets a kernel can be built for, in increasing order of preference
+enum RangeKernelLevel {
+    KERNELS_AUTO,
+    KERNELS_SCALAR,
+    KERNELS_SSE41,
+    KERNELS_AVX2
+};
+
+// Element-wise kernels over RANGE_KERNEL_WIDTH intervals, each given as an array of minimums and an
+// array of maximums. Join and widen write their result to out and return true if it differs from
+// the first input.
+struct RangeKernels {
+    // Are all bounds equal, stops at the first difference
+    bool (*equal)(const int* lhs_min, const int* lhs_max, const int* rhs_min, const int* rhs_max);
+
+    // out = [min(lhs_min, rhs_min), max(lhs_max, rhs_max)]
+    bool (*join)(const int* lhs_min, const int* lhs_max, const int* rhs_min, const int* rhs_max,
+                 int* out_min, int* out_max);
+
+    // Bounds of current that grew compared to previous become INT_MIN or INT_MAX
+    bool (*widen)(const int* current_min, const int* current_max, const int* previous_min,
+                  const int* previous_max, int* out_min, int* out_max);
+
+    RangeKernelLevel level;
+};
+
+// ================== SCALAR ================== //
+
+inline bool equalScalar(const int* lhs_min, const int* lhs_max, const int* rhs_min, const int* rhs_max) {
+    for (unsigned i = 0; i < RANGE_KERNEL_WIDTH; ++i) {
+        if (lhs_min[i] != rhs_min[i] || lhs_max[i] != rhs_max[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool joinScalar(const int* lhs_min, const int* lhs_max, const int* rhs_min, const int* rhs_max,
+                       int* out_min, int* out_max) {
+    bool changed = false;
+    for (unsigned i = 0; i < RANGE_KERNEL_WIDTH; ++i) {
+        int min_value = rhs_min[i] < lhs_min[i] ? rhs_min[i] : lhs_min[i];
+        int max_value = rhs_max[i] > lhs_max[i] ? rhs_max[i] : lhs_max[i];
+        changed |= min_value != lhs_min[i] || max_value != lhs_max[i];
+        out_min[i] = min_value;
+        out_max[i] = max_value;
+    }
+    return changed;
+}
+
+inline bool widenScalar(const int* current_min, const int* current_max, const int* previous_min,
+                        const int* previous_max, int* out_min, int* out_max) {
+    bool widened = false;
+    for (unsigned i = 0; i < RANGE_KERNEL_WIDTH; ++i) {
+        bool grew_max = current_max[i] > previous_max[i];
+        bool grew_min = current_min[i] < previous_min[i];
+        widened |= grew_max || grew_min;
+        out_max[i] = grew_max ? INT_MAX : current_max[i];
+        out_min[i] = grew_min ? INT_MIN : current_min[i];
+    }
+    return widened;
+}
+
+#ifdef RANGE_KERNELS_X86
+
+// ================== SSE4.1, 4 INTERVALS AT ONCE ================== //
+
+__attribute__((target("sse4.1")))
+inline bool equalSSE41(const int* lhs_min, const int* lhs_max, const int* rhs_min, const int* rhs_max) {
+    for (unsigned i = 0; i < RANGE_KERNEL_WIDTH; i += 4) {
+        __m128i mins = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(lhs_min + i)),
+                                     _mm_loadu_si128((const __m128i*)(rhs_min + i)));
+        __m128i maxs = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(lhs_max + i)),
+                                     _mm_loadu_si128((const __m128i*)(rhs_max + i)));
+        __m128i diff = _mm_or_si128(mins, maxs);
+        if (!_mm_testz_si128(diff, diff)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+__attribute__((target("sse4.1")))
+inline bool joinSSE41(const int* lhs_min, const int* lhs_max, const int* rhs_min, const int* rhs_max,
+                      int* out_min, int* out_max) {
+    __m128i changed = _mm_setzero_si128();
+    for (unsigned i = 0; i < RANGE_KERNEL_WIDTH; i += 4) {
+        __m128i old_min = _mm_loadu_si128((const __m128i*)(lhs_min + i));
+        __m128i old_max = _mm_loadu_si128((const __m128i*)(lhs_max + i));
+        __m128i new_min = _mm_min_epi32(old_min, _mm_loadu_si128((const __m128i*)(rhs_min + i)));
+        __m128i new_max = _mm_max_epi32(old_max, _mm_loadu_si128((const __m128i*)(rhs_max + i)));
+        changed = _mm_or_si128(changed, _mm_xor_si128(old_min, new_min));
+        changed = _mm_or_si128(changed, _mm_xor_si128(old_max, new_max));
+        _mm_storeu_si128((__m128i*)(out_min + i), new_min);
+        _mm_storeu_si128((__m128i*)(out_max + i), new_max);
+    }
+    return !_mm_testz_si128(changed, changed);
+}
+
+__attribute__((target("sse4.1")))
+inline bool widenSSE41(const int* current_min, const int* current_max, const int* previous_min,
+                       const int* previous_max, int* out_min, int* out_max) {
+    const __m128i top = _mm_set1_epi32(INT_MAX);
+    const __m128i bottom = _mm_set1_epi32(INT_MIN);
+    __m128i widened = _mm_setzero_si128();
+    for (unsigned i = 0; i < RANGE_KERNEL_WIDTH; i += 4) {
+        __m128i cur_min = _mm_loadu_si128((const __m128i*)(current_min + i));
+        __m128i cur_max = _mm_loadu_si128((const __m128i*)(current_max + i));
+        __m128i grew_max = _mm_cmpgt_epi32(cur_max, _mm_loadu_si128((const __m128i*)(previous_max + i)));
+        __m128i grew_min = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(previous_min + i)), cur_min);
+        widened = _mm_or_si128(widened, _mm_or_si128(grew_max, grew_min));
+        _mm_storeu_si128((__m128i*)(out_max + i), _mm_blendv_epi8(cur_max, top, grew_max));
+        _mm_storeu_si128((__m128i*)(out_min + i), _mm_blendv_epi8(cur_min, bottom, grew_min));
+    }
+    return !_mm_testz_si128(widened, widened);
+}
+
+// ================== AVX2, 8 INTERVALS AT ONCE ================== //
+
+__attribute__((target("avx2")))
+inline bool equalAVX2(const int* lhs_min, const int* lhs_max, const int* rhs_min, const int* rhs_max) {
+    for (unsigned i = 0; i < RANGE_KERNEL_WIDTH; i += 8) {
+        __m256i mins = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(lhs_min + i)),
+                                        _mm256_loadu_si256((const __m256i*)(rhs_min + i)));
+        __m256i maxs = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(lhs_max + i)),
+                                        _mm256_loadu_si256((const __m256i*)(rhs_max + i)));
+        __m256i diff = _mm256_or_si256(mins, maxs);
+        if (!_mm256_testz_si256(diff, diff)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+__attribute__((target("avx2")))
+inline bool joinAVX2(const int* lhs_min, const int* lhs_max, const int* rhs_min, const int* rhs_max,
+                     int* out_min, int* out_max) {
+    __m256i changed = _mm256_setzero_si256();
+    for (unsigned i = 0; i < RANGE_KERNEL_WIDTH; i += 8) {
+        __m256i old_min = _mm256_loadu_si256((const __m256i*)(lhs_min + i));
+        __m256i old_max = _mm256_loadu_si256((const __m256i*)(lhs_max + i));
+        __m256i new_min = _mm256_min_epi32(old_min, _mm256_loadu_si256((const __m256i*)(rhs_min + i)));
+        __m256i new_max = _mm256_max_epi32(old_max, _mm256_loadu_si256((const __m256i*)(rhs_max + i)));
+        changed = _mm256_or_si256(changed, _mm256_xor_si256(old_min, new_min));
+        changed = _mm256_or_si256(changed, _mm256_xor_si256(old_max, new_max));
+        _mm256_storeu_si256((__m256i*)(out_min + i), new_min);
+        _mm256_storeu_si256((__m256i*)(out_max + i), new_max);
+    }
+    return !_mm256_testz_si256(changed, changed);
+}
+
+__attribute__((target("avx2")))
+inline bool widenAVX2(const int* current_min, const int* current_max, const int* previous_min,
+                      const int* previous_max, int* out_min, int* out_max) {
+    const __m256i top = _mm256_set1_epi32(INT_MAX);
+    const __m256i bottom = _mm256_set1_epi32(INT_MIN);
+    __m256i widened = _mm256_setzero_si256();
+    for (unsigned i = 0; i < RANGE_KERNEL_WIDTH; i += 8) {
+        __m256i cur_min = _mm256_loadu_si256((const __m256i*)(current_min + i));
+        __m256i cur_max = _mm256_loadu_si256((const __m256i*)(current_max + i));
+        __m256i grew_max = _mm256_cmpgt_epi32(cur_max, _mm256_loadu_si256((const __m256i*)(previous_max + i)));
+        __m256i grew_min = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)(previous_min + i)), cur_min);
+        widened = _mm256_or_si256(widened, _mm256_or_si256(grew_max, grew_min));
+        _mm256_storeu_si256((__m256i*)(out_max + i), _mm256_blendv_epi8(cur_max, top, grew_max));
+        _mm256_storeu_si256((__m256i*)(out_min + i), _mm256_blendv_epi8(cur_min, bottom, grew_min));
+    }
+    return !_mm256_testz_si256(widened, widened);
+}
+
+#endif
+
+// ================== SELECTION ================== //
+
+// The kernels for level. A level the host does not support falls back to the best one it does.
+inline RangeKernels makeRangeKernels(RangeKernelLevel level) {
+#ifdef RANGE_KERNELS_X86
+    __builtin_cpu_init();
+    bool has_avx2 = __builtin_cpu_supports("avx2");
+    bool has_sse41 = __builtin_cpu_supports("sse4.1");
+
+    if ((level == KERNELS_AUTO || level == KERNELS_AVX2) && has_avx2) {
+        return RangeKernels{equalAVX2, joinAVX2, widenAVX2, KERNELS_AVX2};
+    }
+
+    if (level != KERNELS_SCALAR && has_sse41) {
+        return RangeKernels{equalSSE41, joinSSE41, widenSSE41, KERNELS_SSE41};
+    }
+#endif
+    return RangeKernels{equalScalar, joinScalar, widenScalar, KERNELS_SCALAR};
+}
+
+// The kernels in use, picked for the host the first time they are needed
+inline RangeKernels& getRangeKernels() {
+    static RangeKernels kernels = makeRangeKernels(KERNELS_AUTO);
+    return kernels;
+}
+
+// Use the kernels for level from now on
+inline void setRangeKernels(RangeKernelLevel level) {
+    getRangeKernels() = makeRangeKernels(level);
+}
+
+#endif
@@ -0,0 +1,391 @@
+#ifndef RANGES_H
+#define RANGES_H
+
+// LLVM Includes
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Value.h"
+#include "llvm/Support/Allocator.h"
+
+// Personal Includes
+#include "RangeKernels.h"
+#include "VariableRange.h"
+
+// STL Includes
+#include <cstdint>
+#include <vector>
+
+// usings
+using namespace llvm;
+
+// Number of values whose ranges are stored together in one chunk
+#define RANGE_CHUNK_SIZE 64
+
+static_assert(RANGE_CHUNK_SIZE == RANGE_KERNEL_WIDTH, "kernels work on whole chunks");
+
+// Hash of the range of the value numbered index. States are hashed as the XOR of the hashes of
+// their live slots, which can be updated on every write without looking at the other slots.
+inline uint64_t hashSlot(unsigned index, int min_value, int max_value) {
+    // splitmix64 finalizer
+    uint64_t hash = (uint64_t(uint32_t(min_value)) << 32 | uint32_t(max_value)) ^
+                    (uint64_t(index) * 0x9E3779B97F4A7C15ULL);
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+// A fixed size piece of a range state. The bounds are stored as separate arrays so that joins,
+// widening and comparisons are linear scans over contiguous memory. A slot that is not live always
+// holds [INT_MIN, INT_MAX], which lets the kernels ignore the live bits when combining bounds.
+struct RangeChunk {
+    alignas(32) int min_values[RANGE_CHUNK_SIZE];
+    alignas(32) int max_values[RANGE_CHUNK_SIZE];
+
+    // Bit i is set if slot i holds a range
+    uint64_t live;
+
+    // XOR of the hashes of all live slots, see hashSlot
+    uint64_t hash;
+
+    // Number of states sharing this chunk, it is copied before being written to if shared
+    unsigned refs;
+};
+
+// Gives every value the analysis tracks a dense index, and owns the memory of all chunks. Chunks
+// come from the arena and are recycled once no state refers to them anymore.
+class ValueNumbering {
+public:
+    explicit ValueNumbering(BumpPtrAllocator& arena) : arena(arena) {}
+
+    ValueNumbering(const ValueNumbering&) = delete;
+    ValueNumbering& operator=(const ValueNumbering&) = delete;
+
+    // Give val the next index, if it does not have one yet
+    void number(Value* val) {
+        if (numbers.insert({val, static_cast<unsigned>(values.size())}).second) {
+            values.push_back(val);
+        }
+    }
+
+    // Is val tracked, and if so what is its index
+    bool lookup(Value* val, unsigned& index) const {
+        auto number = numbers.find(val);
+        if (number == numbers.end()) {
+            return false;
+        }
+
+        index = number->second;
+        return true;
+    }
+
+    bool contains(Value* val) const {
+        return numbers.count(val);
+    }
+
+    Value* getValue(unsigned index) const {
+        return values[index];
+    }
+
+    unsigned size() const {
+        return values.size();
+    }
+
+    unsigned getNumChunks() const {
+        return (values.size() + RANGE_CHUNK_SIZE - 1) / RANGE_CHUNK_SIZE;
+    }
+
+    // A chunk with no live slots, owned by the caller
+    RangeChunk* allocateChunk() {
+        RangeChunk* chunk = newChunk();
+        std::fill(chunk->min_values, chunk->min_values + RANGE_CHUNK_SIZE, INT_MIN);
+        std::fill(chunk->max_values, chunk->max_values + RANGE_CHUNK_SIZE, INT_MAX);
+        chunk->live = 0;
+        chunk->hash = 0;
+        chunk->refs = 1;
+        return chunk;
+    }
+
+    // A copy of chunk, owned by the caller
+    RangeChunk* copyChunk(const RangeChunk* chunk) {
+        RangeChunk* copy = newChunk();
+        *copy = *chunk;
+        copy->refs = 1;
+        return copy;
+    }
+
+    // Drop one reference to chunk, recycling it if it was the last one
+    void releaseChunk(RangeChunk* chunk) {
+        if (--chunk->refs == 0) {
+            free_chunks.push_back(chunk);
+        }
+    }
+
+private:
+    RangeChunk* newChunk() {
+        if (free_chunks.empty()) {
+            return arena.Allocate<RangeChunk>();
+        }
+
+        RangeChunk* chunk = free_chunks.back();
+        free_chunks.pop_back();
+        return chunk;
+    }
+
+    BumpPtrAllocator& arena;
+    DenseMap<Value*, unsigned> numbers;
+    std::vector<Value*> values;
+    std::vector<RangeChunk*> free_chunks;
+};
+
+// The ranges of all tracked values at one point of the program, indexed by value number. Copying a
+// Ranges shares all of its chunks, a chunk is only copied when a shared one is written to. A
+// chunk that is missing has no live slots. Every state keeps the hash of its contents up to date,
+// so telling two different states apart usually takes a single compare.
+class Ranges {
+public:
+    // Empty ranges that are not attached to a numbering, may only be read or assigned to
+    Ranges() : numbering(nullptr), hash(0) {}
+
+    explicit Ranges(ValueNumbering& numbering)
+        : numbering(&numbering), chunks(numbering.getNumChunks(), nullptr), hash(0) {}
+
+    Ranges(const Ranges& other) : numbering(other.numbering), chunks(other.chunks), hash(other.hash) {
+        retainAll();
+    }
+
+    Ranges& operator=(const Ranges& other) {
+        if (this != &other) {
+            releaseAll();
+            numbering = other.numbering;
+            chunks = other.chunks;
+            hash = other.hash;
+            retainAll();
+        }
+        return *this;
+    }
+
+    ~Ranges() {
+        releaseAll();
+    }
+
+    // Is there a range stored for val
+    bool count(Value* val) const {
+        unsigned index;
+        return numbering && numbering->lookup(val, index) && isLive(index);
+    }
+
+    // The range stored for val, [INT_MIN, INT_MAX] if nothing is known
+    VariableRange get(Value* val) const {
+        unsigned index;
+        if (!numbering || !numbering->lookup(val, index)) {
+            return VariableRange();
+        }
+
+        const RangeChunk* chunk = chunks[index / RANGE_CHUNK_SIZE];
+        if (!chunk) {
+            return VariableRange();
+        }
+
+        unsigned slot = index % RANGE_CHUNK_SIZE;
+        return VariableRange{chunk->min_values[slot], chunk->max_values[slot]};
+    }
+
+    // Store range for val, only copies a chunk if the range actually changes
+    void set(Value* val, const VariableRange& range) {
+        unsigned index;
+        if (!numbering->lookup(val, index)) {
+            return;
+        }
+
+        unsigned slot = index % RANGE_CHUNK_SIZE;
+        const RangeChunk* current = chunks[index / RANGE_CHUNK_SIZE];
+        if (current && (current->live >> slot & 1) && current->min_values[slot] == range.min_value &&
+            current->max_values[slot] == range.max_value) {
+            return;
+        }
+
+        RangeChunk* chunk = getWritableChunk(index / RANGE_CHUNK_SIZE);
+        uint64_t change = hashSlot(index, range.min_value, range.max_value);
+        if (chunk->live >> slot & 1) {
+            change ^= hashSlot(index, chunk->min_values[slot], chunk->max_values[slot]);
+        }
+        chunk->min_values[slot] = range.min_value;
+        chunk->max_values[slot] = range.max_value;
+        chunk->live |= uint64_t(1) << slot;
+        chunk->hash ^= change;
+        hash ^= change;
+    }
+
+    // Remove the range stored for val
+    void erase(Value* val) {
+        unsigned index;
+        if (!numbering->lookup(val, index) || !isLive(index)) {
+            return;
+        }
+
+        unsigned slot = index % RANGE_CHUNK_SIZE;
+        RangeChunk* chunk = getWritableChunk(index / RANGE_CHUNK_SIZE);
+        uint64_t change = hashSlot(index, chunk->min_values[slot], chunk->max_values[slot]);
+        chunk->hash ^= change;
+        hash ^= change;
+        chunk->min_values[slot] = INT_MIN;
+        chunk->max_values[slot] = INT_MAX;
+        chunk->live &= ~(uint64_t(1) << slot);
+    }
+
+    // Both states hold the same values with the same ranges. Different hashes settle it right away,
+    // otherwise the chunks are compared and shared chunks are skipped.
+    bool operator==(const Ranges& other) const {
+        if (hash != other.hash) {
+            return false;
+        }
+
+        for (unsigned i = 0; i < chunks.size(); ++i) {
+            const RangeChunk* lhs = chunks[i];
+            const RangeChunk* rhs = i < other.chunks.size() ? other.chunks[i] : nullptr;
+            if (lhs == rhs) {
+                continue;
+            }
+
+            if (!lhs || !rhs) {
+                if ((lhs && lhs->live) || (rhs && rhs->live)) {
+                    return false;
+                }
+                continue;
+            }
+
+            if (lhs->live != rhs->live ||
+                !getRangeKernels().equal(lhs->min_values, lhs->max_values, rhs->min_values, rhs->max_values)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Keep only the values live in both states, and widen each range to cover both ranges
+    void join(const Ranges& other) {
+        for (unsigned i = 0; i < chunks.size(); ++i) {
+            const RangeChunk* lhs = chunks[i];
+            const RangeChunk* rhs = other.chunks[i];
+            if (lhs == rhs || !lhs) {
+                continue;
+            }
+
+            if (!rhs) {
+                hash ^= chunks[i]->hash;
+                numbering->releaseChunk(chunks[i]);
+                chunks[i] = nullptr;
+                continue;
+            }
+
+            // Untracked slots hold [INT_MIN, INT_MAX], so min and max drop them as well
+            alignas(32) int min_values[RANGE_CHUNK_SIZE];
+            alignas(32) int max_values[RANGE_CHUNK_SIZE];
+            bool changed = getRangeKernels().join(lhs->min_values, lhs->max_values, rhs->min_values,
+                                                  rhs->max_values, min_values, max_values);
+            uint64_t live = lhs->live & rhs->live;
+            if (!changed && live == lhs->live) {
+                continue;
+            }
+
+            storeChunk(i, min_values, max_values, live);
+        }
+    }
+
+    // Any bound that grew compared to original is pushed to the next of the sorted thresholds, or
+    // to INT_MIN or INT_MAX past the last one. Returns true if a bound was widened.
+    bool widen(const Ranges& original, const std::vector<int>& thresholds = std::vector<int>()) {
+        bool widened = false;
+
+        for (unsigned i = 0; i < chunks.size(); ++i) {
+            const RangeChunk* current = chunks[i];
+            const RangeChunk* previous = original.chunks[i];
+            if (current == previous || !current || !previous) {
+                continue;
+            }
+
+            // Values that were not tracked before hold [INT_MIN, INT_MAX] and never grow
+            alignas(32) int min_values[RANGE_CHUNK_SIZE];
+            alignas(32) int max_values[RANGE_CHUNK_SIZE];
+            if (!getRangeKernels().widen(current->min_values, current->max_values, previous->min_values,
+                                         previous->max_values, min_values, max_values)) {
+                continue;
+            }
+
+            // The kernel moved every grown bound to the end of the domain, stop at a threshold first
+            if (!thresholds.empty()) {
+                for (unsigned slot = 0; slot < RANGE_CHUNK_SIZE; ++slot) {
+                    if (max_values[slot] != current->max_values[slot]) {
+                        max_values[slot] = thresholdAbove(current->max_values[slot], thresholds);
+                    }
+                    if (min_values[slot] != current->min_values[slot]) {
+                        min_values[slot] = thresholdBelow(current->min_values[slot], thresholds);
+                    }
+                }
+            }
+
+            storeChunk(i, min_values, max_values, current->live);
+            widened = true;
+        }
+
+        return widened;
+    }
+
+private:
+    bool isLive(unsigned index) const {
+        const RangeChunk* chunk = chunks[index / RANGE_CHUNK_SIZE];
+        return chunk && (chunk->live >> (index % RANGE_CHUNK_SIZE) & 1);
+    }
+
+    // The chunk at i, copied first if another state shares it
+    RangeChunk* getWritableChunk(unsigned i) {
+        RangeChunk* chunk = chunks[i];
+        if (!chunk) {
+            chunks[i] = numbering->allocateChunk();
+        }
+        else if (chunk->refs > 1) {
+            chunks[i] = numbering->copyChunk(chunk);
+            numbering->releaseChunk(chunk);
+        }
+        return chunks[i];
+    }
+
+    // Replace the contents of the chunk at i
+    void storeChunk(unsigned i, const int* min_values, const int* max_values, uint64_t live) {
+        RangeChunk* chunk = getWritableChunk(i);
+        std::copy(min_values, min_values + RANGE_CHUNK_SIZE, chunk->min_values);
+        std::copy(max_values, max_values + RANGE_CHUNK_SIZE, chunk->max_values);
+        chunk->live = live;
+
+        uint64_t chunk_hash = 0;
+        for (uint64_t slots = live; slots; slots &= slots - 1) {
+            unsigned slot = __builtin_ctzll(slots);
+            chunk_hash ^= hashSlot(i * RANGE_CHUNK_SIZE + slot, min_values[slot], max_values[slot]);
+        }
+        hash ^= chunk->hash ^ chunk_hash;
+        chunk->hash = chunk_hash;
+    }
+
+    void retainAll() {
+        for (RangeChunk* chunk : chunks) {
+            if (chunk) {
+                ++chunk->refs;
+            }
+        }
+    }
+
+    void releaseAll() {
+        for (RangeChunk* chunk : chunks) {
+            if (chunk) {
+                numbering->releaseChunk(chunk);
+            }
+        }
+    }
+
+    ValueNumbering* numbering;
+    std::vector<RangeChunk*> chunks;
+
+    // XOR of the hashes of all chunks
+    uint64_t hash;
+};
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+// LLVM Includes
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+// STL Includes
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// POSIX Includes
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// usings
+using namespace llvm;
+
+// Bump whenever the analysis can find something different for the same IR, old entries then miss
+#define RESULT_CACHE_VERSION 7
+
+// First word of every entry, "BCRC" in a little endian file
+#define RESULT_CACHE_MAGIC 0x43524342u
+
+// An access that is not proven in bounds. Accesses are given by their position among the
+// instructions of the function, which the hash of its IR pins down.
+struct CachedFinding {
+    uint32_t position;
+    int32_t array_size;
+    int32_t index_min;
+    int32_t index_max;
+    uint32_t out_of_bounds;
+};
+
+// What checking the accesses of one function found
+struct CachedResult {
+    uint32_t num_proven_safe = 0;
+    uint32_t num_unproven = 0;
+    uint32_t num_out_of_bounds = 0;
+
+    // Accesses that are not proven in bounds, in program order
+    std::vector<CachedFinding> findings;
+};
+
+// Stores the result of each function in a file of its own, named after the hash of its IR. An
+// entry is a flat array of 32 bit words, so reading it is one mmap and a few copies:
+//
+//   magic, version, proven safe, unproven, out of bounds, #findings,
+//   (position, array size, index min, index max, out of bounds)...
+class ResultCache {
+public:
+    explicit ResultCache(StringRef directory) : directory(directory) {}
+
+    // Hash of everything the result of F depends on: its IR, the data layout that sizes the
+    // arrays, the options of the analysis and the version of the cache
+    static std::string hashFunction(const Function& F, StringRef options) {
+        std::string text;
+        raw_string_ostream os(text);
+        os << "version " << RESULT_CACHE_VERSION << "\n" << options << "\n"
+           << F.getParent()->getDataLayoutStr() << "\n";
+        F.print(os);
+        os.flush();
+
+        MD5 hash;
+        hash.update(text);
+        MD5::MD5Result result;
+        hash.final(result);
+        return std::string(result.digest().str());
+    }
+
+    // Reads the entry for key into result, false if there is none or it is not a valid entry
+    bool lookup(StringRef key, CachedResult& result) const {
+        SmallString<128> path = getPath(key);
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(HEADER_WORDS * sizeof(uint32_t))) {
+            ::close(fd);
+            return false;
+        }
+
+        size_t size = info.st_size;
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+
+        bool valid = parse(static_cast<const char*>(data), size, result);
+        munmap(data, size);
+        return valid;
+    }
+
+    // Writes the entry for key. The entry is written to a temporary file and renamed, so
+    // concurrent builds never read half an entry.
+    void store(StringRef key, const CachedResult& result) const {
+        std::vector<uint32_t> words = {RESULT_CACHE_MAGIC, RESULT_CACHE_VERSION, result.num_proven_safe,
+                                       result.num_unproven, result.num_out_of_bounds,
+                                       static_cast<uint32_t>(result.findings.size())};
+        for (const CachedFinding& finding : result.findings) {
+            words.push_back(finding.position);
+            words.push_back(static_cast<uint32_t>(finding.array_size));
+            words.push_back(static_cast<uint32_t>(finding.index_min));
+            words.push_back(static_cast<uint32_t>(finding.index_max));
+            words.push_back(finding.out_of_bounds);
+        }
+
+        if (sys::fs::create_directories(directory)) {
+            return;
+        }
+
+        int fd;
+        SmallString<128> temporary;
+        if (sys::fs::createUniqueFile(Twine(getPath(key)) + ".tmp%%%%%%", fd, temporary)) {
+            return;
+        }
+
+        {
+            raw_fd_ostream os(fd, true);
+            os.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t));
+        }
+
+        if (sys::fs::rename(temporary, getPath(key))) {
+            sys::fs::remove(temporary);
+        }
+    }
+
+private:
+    // Words before the findings: magic, version, the three counts and the number of findings
+    static const unsigned HEADER_WORDS = 6;
+
+    // Words of each finding
+    static const unsigned FINDING_WORDS = 5;
+
+    SmallString<128> getPath(StringRef key) const {
+        SmallString<128> path(directory);
+        sys::path::append(path, key + ".bcr");
+        return path;
+    }
+
+    static bool parse(const char* data, size_t size, CachedResult& result) {
+        uint32_t header[HEADER_WORDS];
+        memcpy(header, data, sizeof(header));
+        if (header[0] != RESULT_CACHE_MAGIC || header[1] != RESULT_CACHE_VERSION) {
+            return false;
+        }
+
+        uint64_t num_findings = header[5];
+        if (size != (HEADER_WORDS + FINDING_WORDS * num_findings) * sizeof(uint32_t)) {
+            return false;
+        }
+
+        result.num_proven_safe = header[2];
+        result.num_unproven = header[3];
+        result.num_out_of_bounds = header[4];
+
+        const char* current = data + sizeof(header);
+        result.findings.resize(num_findings);
+        for (CachedFinding& finding : result.findings) {
+            uint32_t words[FINDING_WORDS];
+            memcpy(words, current, sizeof(words));
+            finding.position = words[0];
+            finding.array_size = static_cast<int32_t>(words[1]);
+            finding.index_min = static_cast<int32_t>(words[2]);
+            finding.index_max = static_cast<int32_t>(words[3]);
+            finding.out_of_bounds = words[4];
+            current += sizeof(words);
+        }
+        return true;
+    }
+
+    std::string directory;
+};
+
+#endif
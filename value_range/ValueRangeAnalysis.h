@@ -0,0 +1,62 @@
+#ifndef VALUE_RANGE_ANALYSIS_H
+#define VALUE_RANGE_ANALYSIS_H
+
+// LLVM Includes
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/PassManager.h"
+
+// Personal Includes
+#include "VariableRange.h"
+
+// STL Includes
+#include <memory>
+
+// usings
+using namespace llvm;
+
+// The ranges found for one function. The analysis manager caches it, so every pass asking for it
+// shares one computation until the function changes.
+class ValueRangeInfo {
+public:
+    // What the analysis computed, only known to the bounds check passes themselves
+    struct Impl;
+
+    explicit ValueRangeInfo(std::unique_ptr<Impl> impl);
+    ValueRangeInfo(ValueRangeInfo&& other);
+    ValueRangeInfo& operator=(ValueRangeInfo&& other);
+    ~ValueRangeInfo();
+
+    // The range of val where ctx uses it, [INT_MIN, INT_MAX] if nothing is known about val there
+    VariableRange getRange(Value* val, Instruction* ctx) const;
+
+    // Can ctx be reached at all, given the ranges of the compares guarding it
+    bool isReachable(Instruction* ctx) const;
+
+    // Number of visits the solver needed to converge
+    unsigned getSolverIterations() const;
+
+    // The ranges refer to the IR, dominator tree, loops and scalar evolution as they were analyzed.
+    // They are recomputed once any of these is not preserved.
+    bool invalidate(Function& F, const PreservedAnalyses& PA, FunctionAnalysisManager::Invalidator& inv);
+
+    Impl& getImpl() {
+        return *impl;
+    }
+
+private:
+    std::unique_ptr<Impl> impl;
+};
+
+// Computes the value ranges of a function for the new pass manager
+class ValueRangeAnalysis : public AnalysisInfoMixin<ValueRangeAnalysis> {
+    friend AnalysisInfoMixin<ValueRangeAnalysis>;
+    static AnalysisKey Key;
+
+public:
+    using Result = ValueRangeInfo;
+
+    Result run(Function& F, FunctionAnalysisManager& FAM);
+};
+
+#endif
@@ -2,8 +2,10 @@
 #define VARIABLE_RANGE_H
 
 // LLVM Includes
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/Pass.h"
 #include "llvm/IR/Function.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/Support/Format.h"
@@ -16,6 +18,7 @@
 #include <algorithm>
 #include <iostream>
 #include <limits.h>
+#include <vector>
 
 // usings
 using namespace llvm;
@@ -23,15 +26,22 @@ using namespace llvm;
 using std::ostream;
 using std::max;
 using std::min;
+using std::vector;
 
 // Struct that represents the variable range. By default it is the range from INT_MIN and INT_MAX
 struct VariableRange {
     int min_value = INT_MIN;
     int max_value = INT_MAX;
 
-    bool operator==(VariableRange& other) {
+    constexpr bool operator==(const VariableRange& other) const {
         return min_value == other.min_value && max_value == other.max_value;
     }
+
+    // Necessary for storing ranges in LLVM's immutable containers
+    void Profile(FoldingSetNodeID& ID) const {
+        ID.AddInteger(min_value);
+        ID.AddInteger(max_value);
+    }
 };
 
 // Print out a range to os
@@ -53,49 +63,39 @@ bool outOfRange(const VariableRange& range, int array_size) {
     return false;
 }
 
-// Check if specific operation will cause overflow or underflow.
-// If it does, return the corresponding value.
-int checkUnderOverFlow(long long lhs, long long rhs, char operation) {
-    switch(operation) {
-        case '+':
-            if (lhs + rhs > INT_MAX) {
-                return INT_MAX;
-            }
-            else if (lhs + rhs < INT_MIN) {
-                return INT_MIN;
-            }
-            return static_cast<int>(lhs + rhs);
-        case '-':
-            if (lhs - rhs > INT_MAX) {
-                return INT_MAX;
-            }
-            else if (lhs - rhs < INT_MIN) {
-                return INT_MIN;
-            }
-            return static_cast<int>(lhs - rhs);
-        case '*':
-            if (lhs * rhs > INT_MAX) {
-                return INT_MAX;
-            }
-            else if (lhs * rhs < INT_MIN) {
-                return INT_MIN;
-            }
-            return static_cast<int>(lhs * rhs);
-        case '/':
-            if (rhs == 0) {
-                return lhs;
-            }
-            else if (lhs / rhs > INT_MAX) {
-                return INT_MAX;
-            }
-            else if (lhs / rhs < INT_MIN) {
-                return INT_MIN;
+// Determines if every value of a range is a valid index of an array
+bool inRange(const VariableRange& range, int array_size) {
+    return range.min_value >= 0 && range.max_value < array_size;
+}
+
+// Determines if every value of inner is also a value of outer
+bool containsRange(const VariableRange& outer, const VariableRange& inner) {
+    return outer.min_value <= inner.min_value && inner.max_value <= outer.max_value;
+}
+
+// Can op on a value of lhs and a value of rhs leave the int range, or that of a signed integer of
+// bits bits if it is narrower, or divide by zero
+bool mayOverflow(const VariableRange& lhs, const VariableRange& rhs, char operation, unsigned bits = 32) {
+    long long smallest = bits >= 32 ? INT_MIN : -(1ll << (bits - 1));
+    long long largest = bits >= 32 ? INT_MAX : (1ll << (bits - 1)) - 1;
+    if (operation == '/') {
+        bool by_zero = rhs.min_value <= 0 && rhs.max_value >= 0;
+        bool min_by_minus_one = lhs.min_value <= smallest && rhs.min_value <= -1 && rhs.max_value >= -1;
+        return by_zero || min_by_minus_one;
+    }
+
+    long long bounds[] = {lhs.min_value, lhs.max_value};
+    long long others[] = {rhs.min_value, rhs.max_value};
+    for (long long first : bounds) {
+        for (long long second : others) {
+            long long result = operation == '+' ? first + second :
+                               operation == '-' ? first - second : first * second;
+            if (result > largest || result < smallest) {
+                return true;
             }
-            return static_cast<int>(lhs / rhs);
-        default:
-            errs() << "INVALID ARGUMENT IN CHECKOVERFLOW FUNCTION: Exitting\n";
-            exit(1);
+        }
     }
+    return false;
 }
 
 // Unions two ranges such that
@@ -103,69 +103,404 @@ VariableRange unionRange(const VariableRange& lhs, const VariableRange& rhs) {
     return VariableRange{min(lhs.min_value, rhs.min_value), max(lhs.max_value, rhs.max_value)};
 }
 
-// Check all combinations of the op on the left and right end of each range
-VariableRange checkAllCombinations(const VariableRange& lhs, const VariableRange& rhs, char op) {
-    int min_value = INT_MAX;
-    int max_value= INT_MIN;
+// Any bound of current that grew compared to previous is pushed to INT_MIN or INT_MAX
+VariableRange widenRange(const VariableRange& previous, const VariableRange& current) {
+    VariableRange output = current;
+    if (current.max_value > previous.max_value) {
+        output.max_value = INT_MAX;
+    }
+
+    if (current.min_value < previous.min_value) {
+        output.min_value = INT_MIN;
+    }
+
+    return output;
+}
+
+// The smallest threshold that is at least value, INT_MAX if there is none. thresholds is sorted.
+int thresholdAbove(int value, const vector<int>& thresholds) {
+    auto threshold = std::lower_bound(thresholds.begin(), thresholds.end(), value);
+    return threshold == thresholds.end() ? INT_MAX : *threshold;
+}
+
+// The largest threshold that is at most value, INT_MIN if there is none. thresholds is sorted.
+int thresholdBelow(int value, const vector<int>& thresholds) {
+    auto threshold = std::upper_bound(thresholds.begin(), thresholds.end(), value);
+    return threshold == thresholds.begin() ? INT_MIN : *(threshold - 1);
+}
+
+// Any bound of current that grew compared to previous only moves to the next threshold past it
+VariableRange widenRange(const VariableRange& previous, const VariableRange& current,
+                         const vector<int>& thresholds) {
+    VariableRange output = current;
+    if (current.max_value > previous.max_value) {
+        output.max_value = thresholdAbove(current.max_value, thresholds);
+    }
+
+    if (current.min_value < previous.min_value) {
+        output.min_value = thresholdBelow(current.min_value, thresholds);
+    }
+
+    return output;
+}
+
+// ================== INTERVAL KERNELS ================== //
+
+// A kernel per operator computes the range of lhs op rhs from the bounds alone, in a fixed number
+// of steps and without branching on the operator. The operators are the chars the analysis hands
+// around: + - * / for the signed arithmetic, % and u for the signed and unsigned remainder, d for
+// the unsigned division, < and > for the left and arithmetic right shift, & and | for the bitwise
+// and and or.
+
+// The value itself if it fits an int, otherwise the bound of the int range on its side
+constexpr int saturate(long long value) {
+    return value > INT_MAX ? INT_MAX : value < INT_MIN ? INT_MIN : static_cast<int>(value);
+}
+
+// lhs + rhs, saturated at INT_MIN and INT_MAX
+constexpr int saturatingAdd(int lhs, int rhs) {
+#if defined(__GNUC__)
+    int result = 0;
+    return __builtin_add_overflow(lhs, rhs, &result) ? (rhs < 0 ? INT_MIN : INT_MAX) : result;
+#else
+    return saturate(static_cast<long long>(lhs) + rhs);
+#endif
+}
+
+// lhs - rhs, saturated at INT_MIN and INT_MAX
+constexpr int saturatingSub(int lhs, int rhs) {
+#if defined(__GNUC__)
+    int result = 0;
+    return __builtin_sub_overflow(lhs, rhs, &result) ? (rhs < 0 ? INT_MAX : INT_MIN) : result;
+#else
+    return saturate(static_cast<long long>(lhs) - rhs);
+#endif
+}
+
+// lhs * rhs, saturated at INT_MIN and INT_MAX
+constexpr int saturatingMul(int lhs, int rhs) {
+#if defined(__GNUC__)
+    int result = 0;
+    return __builtin_mul_overflow(lhs, rhs, &result) ? ((lhs < 0) != (rhs < 0) ? INT_MIN : INT_MAX) : result;
+#else
+    return saturate(static_cast<long long>(lhs) * rhs);
+#endif
+}
+
+// lhs / rhs, saturated at INT_MAX for INT_MIN / -1. A divisor of 0 keeps lhs, like dividing by 1.
+constexpr int saturatingDiv(int lhs, int rhs) {
+    return rhs == 0 ? lhs : lhs == INT_MIN && rhs == -1 ? INT_MAX : lhs / rhs;
+}
+
+// The smallest and largest of four values
+constexpr int min4(int a, int b, int c, int d) {
+    return min(min(a, b), min(c, d));
+}
+
+constexpr int max4(int a, int b, int c, int d) {
+    return max(max(a, b), max(c, d));
+}
+
+// value moved into [low, high]
+constexpr int clampInt(int value, int low, int high) {
+    return value < low ? low : value > high ? high : value;
+}
+
+// All ones from the highest set bit of value down, value is not negative
+constexpr int smearBits(int value) {
+    unsigned bits = static_cast<unsigned>(value);
+    bits |= bits >> 1;
+    bits |= bits >> 2;
+    bits |= bits >> 4;
+    bits |= bits >> 8;
+    bits |= bits >> 16;
+    return static_cast<int>(bits);
+}
+
+// The range of lhs Op rhs for ints, there is a specialization for every operator modeled
+template <char Op>
+struct IntervalKernel;
+
+// Addition is monotone in both operands, the smallest bounds give the smallest sum
+template <>
+struct IntervalKernel<'+'> {
+    static constexpr VariableRange apply(const VariableRange& lhs, const VariableRange& rhs) {
+        return {saturatingAdd(lhs.min_value, rhs.min_value), saturatingAdd(lhs.max_value, rhs.max_value)};
+    }
+};
+
+// Subtraction grows with lhs and shrinks with rhs
+template <>
+struct IntervalKernel<'-'> {
+    static constexpr VariableRange apply(const VariableRange& lhs, const VariableRange& rhs) {
+        return {saturatingSub(lhs.min_value, rhs.max_value), saturatingSub(lhs.max_value, rhs.min_value)};
+    }
+};
+
+// The signs decide which of the products of the bounds is the smallest and the largest
+template <>
+struct IntervalKernel<'*'> {
+    static constexpr VariableRange apply(const VariableRange& lhs, const VariableRange& rhs) {
+        int a = saturatingMul(lhs.min_value, rhs.min_value);
+        int b = saturatingMul(lhs.min_value, rhs.max_value);
+        int c = saturatingMul(lhs.max_value, rhs.min_value);
+        int d = saturatingMul(lhs.max_value, rhs.max_value);
+        return {min4(a, b, c, d), max4(a, b, c, d)};
+    }
+};
+
+// Between two divisors of the same sign the quotient is monotone, so besides the bounds of rhs
+// only -1 and 1 can give the extremes, if rhs holds them. Moving them into rhs makes them a bound
+// otherwise, which is a candidate anyway. Dividing by [0, 0] is undefined, the result could be
+// anything.
+template <>
+struct IntervalKernel<'/'> {
+    static constexpr VariableRange apply(const VariableRange& lhs, const VariableRange& rhs) {
+        int minus_one = clampInt(-1, rhs.min_value, rhs.max_value);
+        int one = clampInt(1, rhs.min_value, rhs.max_value);
+        int quotients[] = {saturatingDiv(lhs.min_value, rhs.min_value), saturatingDiv(lhs.min_value, rhs.max_value),
+                           saturatingDiv(lhs.min_value, minus_one), saturatingDiv(lhs.min_value, one),
+                           saturatingDiv(lhs.max_value, rhs.min_value), saturatingDiv(lhs.max_value, rhs.max_value),
+                           saturatingDiv(lhs.max_value, minus_one), saturatingDiv(lhs.max_value, one)};
+        int a = min4(quotients[0], quotients[1], quotients[2], quotients[3]);
+        int b = min4(quotients[4], quotients[5], quotients[6], quotients[7]);
+        int c = max4(quotients[0], quotients[1], quotients[2], quotients[3]);
+        int d = max4(quotients[4], quotients[5], quotients[6], quotients[7]);
+        return rhs.min_value == 0 && rhs.max_value == 0 ? VariableRange() : VariableRange{min(a, b), max(c, d)};
+    }
+};
 
-    // Check the smallest value possible
-    min_value = min(min_value, checkUnderOverFlow(lhs.min_value, rhs.min_value, op));
-    min_value = min(min_value, checkUnderOverFlow(lhs.min_value, rhs.max_value, op));
-    min_value = min(min_value, checkUnderOverFlow(lhs.max_value, rhs.min_value, op));
-    min_value = min(min_value, checkUnderOverFlow(lhs.max_value, rhs.max_value, op));
+// The signed remainder. Its sign follows the dividend and it is smaller than the divisor in
+// magnitude, a divisor of 0 is left out since the remainder is undefined then.
+template <>
+struct IntervalKernel<'%'> {
+    static constexpr VariableRange apply(const VariableRange& lhs, const VariableRange& rhs) {
+        long long largest = max(-static_cast<long long>(rhs.min_value), static_cast<long long>(rhs.max_value)) - 1;
+        long long min_value = lhs.min_value >= 0 ? 0 : max(static_cast<long long>(lhs.min_value), -largest);
+        long long max_value = lhs.max_value <= 0 ? 0 : min(static_cast<long long>(lhs.max_value), largest);
+        return rhs.min_value == 0 && rhs.max_value == 0 ?
+               VariableRange() : VariableRange{static_cast<int>(min_value), static_cast<int>(max_value)};
+    }
+};
+
+// The unsigned remainder. Only values that are not negative agree with their signed
+// interpretation, anything else could be a huge unsigned value.
+template <>
+struct IntervalKernel<'u'> {
+    static constexpr VariableRange apply(const VariableRange& lhs, const VariableRange& rhs) {
+        return lhs.min_value < 0 || rhs.min_value < 0 ? VariableRange() : IntervalKernel<'%'>::apply(lhs, rhs);
+    }
+};
 
-    // For division, if 1 or -1 is in the range it can yield the smallest value
-    if (op == '/' && rhs.min_value < -1 && -1 < rhs.max_value) {
-        min_value = min(min_value, checkUnderOverFlow(lhs.min_value, -1, op));
-        min_value = min(min_value, checkUnderOverFlow(lhs.max_value, -1, op));
-    } 
-    else if (op == '/' && rhs.min_value < 1 && 1 < rhs.max_value) {
-        min_value = min(min_value, checkUnderOverFlow(lhs.min_value, 1, op));
-        min_value = min(min_value, checkUnderOverFlow(lhs.max_value, 1, op));
+// The unsigned division, of values that are not negative like the unsigned remainder. A divisor of
+// 0 is left out, the smallest divisor is 1 then.
+template <>
+struct IntervalKernel<'d'> {
+    static constexpr VariableRange apply(const VariableRange& lhs, const VariableRange& rhs) {
+        return lhs.min_value < 0 || rhs.min_value < 0 || rhs.max_value == 0 ?
+               VariableRange() :
+               VariableRange{lhs.min_value / max(rhs.max_value, 1), lhs.max_value / max(rhs.min_value, 1)};
     }
+};
 
-    // Check the largest value possible
-    max_value = max(max_value, checkUnderOverFlow(lhs.min_value, rhs.min_value, op));
-    max_value = max(max_value, checkUnderOverFlow(lhs.min_value, rhs.max_value, op));
-    max_value = max(max_value, checkUnderOverFlow(lhs.max_value, rhs.min_value, op));
-    max_value = max(max_value, checkUnderOverFlow(lhs.max_value, rhs.max_value, op));
+// The left shift by [0, 31], a multiplication by a power of 2. Shifts are used to mix bits, so
+// unlike the other operators a result past the int range gives nothing instead of its bound.
+template <>
+struct IntervalKernel<'<'> {
+    static constexpr VariableRange apply(const VariableRange& lhs, const VariableRange& rhs) {
+        long long shortest = 1ll << clampInt(rhs.min_value, 0, 31);
+        long long longest = 1ll << clampInt(rhs.max_value, 0, 31);
+        long long smallest = min(lhs.min_value * shortest, lhs.min_value * longest);
+        long long largest = max(lhs.max_value * shortest, lhs.max_value * longest);
+        bool fits = rhs.min_value >= 0 && rhs.max_value <= 31 && smallest >= INT_MIN && largest <= INT_MAX;
+        return fits ? VariableRange{static_cast<int>(smallest), static_cast<int>(largest)} : VariableRange();
+    }
+};
 
-    // For division, if 1 or -1 is in the range it can yield the largest value
-    if (op == '/' && rhs.min_value < -1 && -1 < rhs.max_value) {
-        max_value = max(max_value, checkUnderOverFlow(lhs.min_value, -1, op));
-        max_value = max(max_value, checkUnderOverFlow(lhs.max_value, -1, op));
-    } 
-    else if (op == '/' && rhs.min_value < 1 && 1 < rhs.max_value) {
-        max_value = max(max_value, checkUnderOverFlow(lhs.min_value, 1, op));
-        max_value = max(max_value, checkUnderOverFlow(lhs.max_value, 1, op));
+// The arithmetic right shift by [0, 31]. It grows with lhs, and moves lhs towards 0 or -1 the
+// further it shifts, so the extremes come from the bounds.
+template <>
+struct IntervalKernel<'>'> {
+    static constexpr VariableRange apply(const VariableRange& lhs, const VariableRange& rhs) {
+        int shortest = clampInt(rhs.min_value, 0, 31);
+        int longest = clampInt(rhs.max_value, 0, 31);
+        bool defined = rhs.min_value >= 0 && rhs.max_value <= 31;
+        return defined ? VariableRange{min(lhs.min_value >> shortest, lhs.min_value >> longest),
+                                       max(lhs.max_value >> shortest, lhs.max_value >> longest)} :
+                         VariableRange();
     }
+};
 
-    return { min_value, max_value };
+// The bitwise and only clears bits: with a side that is not negative the result is in between 0
+// and it, with both negative it keeps the sign bit and is at most the smaller one.
+template <>
+struct IntervalKernel<'&'> {
+    static constexpr VariableRange apply(const VariableRange& lhs, const VariableRange& rhs) {
+        bool lhs_positive = lhs.min_value >= 0;
+        bool rhs_positive = rhs.min_value >= 0;
+        bool negative = lhs.max_value < 0 && rhs.max_value < 0;
+        int max_value = lhs_positive && rhs_positive ? min(lhs.max_value, rhs.max_value) :
+                        lhs_positive ? lhs.max_value :
+                        rhs_positive ? rhs.max_value :
+                        negative ? min(lhs.max_value, rhs.max_value) : max(lhs.max_value, rhs.max_value);
+        return {lhs_positive || rhs_positive ? 0 : INT_MIN, max_value};
+    }
+};
+
+// The bitwise or only sets bits: at least the larger side if neither is negative, at least the
+// smaller side otherwise. It is negative with a negative side, and otherwise stays below the
+// next power of 2.
+template <>
+struct IntervalKernel<'|'> {
+    static constexpr VariableRange apply(const VariableRange& lhs, const VariableRange& rhs) {
+        bool positive = lhs.min_value >= 0 && rhs.min_value >= 0;
+        bool negative = lhs.max_value < 0 || rhs.max_value < 0;
+        return {positive ? max(lhs.min_value, rhs.min_value) : min(lhs.min_value, rhs.min_value),
+                negative ? -1 : smearBits(max(max(lhs.max_value, rhs.max_value), 0))};
+    }
+};
+
+// The range of lhs op rhs for ints, nothing is known about operators without a kernel
+constexpr VariableRange applyKernel(char op, const VariableRange& lhs, const VariableRange& rhs) {
+    switch (op) {
+        case '+':
+            return IntervalKernel<'+'>::apply(lhs, rhs);
+        case '-':
+            return IntervalKernel<'-'>::apply(lhs, rhs);
+        case '*':
+            return IntervalKernel<'*'>::apply(lhs, rhs);
+        case '/':
+            return IntervalKernel<'/'>::apply(lhs, rhs);
+        case '%':
+            return IntervalKernel<'%'>::apply(lhs, rhs);
+        case 'u':
+            return IntervalKernel<'u'>::apply(lhs, rhs);
+        case 'd':
+            return IntervalKernel<'d'>::apply(lhs, rhs);
+        case '<':
+            return IntervalKernel<'<'>::apply(lhs, rhs);
+        case '>':
+            return IntervalKernel<'>'>::apply(lhs, rhs);
+        case '&':
+            return IntervalKernel<'&'>::apply(lhs, rhs);
+        case '|':
+            return IntervalKernel<'|'>::apply(lhs, rhs);
+        default:
+            return VariableRange();
+    }
 }
 
-// If adding two variables, returns the new range when adding together.
-VariableRange addRanges(const VariableRange& lhs, const VariableRange& rhs) {
-    return checkAllCombinations(lhs, rhs, '+');
+// The kernels are checked where they are compiled
+static_assert(IntervalKernel<'+'>::apply({INT_MAX - 1, INT_MAX}, {1, 2}) == VariableRange{INT_MAX, INT_MAX},
+              "addition saturates");
+static_assert(IntervalKernel<'-'>::apply({0, 10}, {-5, 5}) == VariableRange{-5, 15}, "subtraction");
+static_assert(IntervalKernel<'*'>::apply({-3, 2}, {-4, 5}) == VariableRange{-15, 12}, "multiplication");
+static_assert(IntervalKernel<'/'>::apply({10, 10}, {-5, 5}) == VariableRange{-10, 10}, "division by -1 and 1");
+static_assert(IntervalKernel<'<'>::apply({1, 3}, {0, 4}) == VariableRange{1, 48}, "left shift");
+static_assert(IntervalKernel<'>'>::apply({-16, 16}, {1, 2}) == VariableRange{-8, 8}, "right shift");
+static_assert(IntervalKernel<'&'>::apply({-100, 100}, {0, 15}) == VariableRange{0, 15}, "and with a mask");
+static_assert(IntervalKernel<'|'>::apply({0, 5}, {8, 8}) == VariableRange{8, 15}, "or of positive values");
+
+// Values wider than an int are tracked with the same ranges: a bound of INT_MIN or INT_MAX stands
+// for every value below or above it, since the wide value may lie beyond what an int holds.
+
+// The range of op on values wider than an int. A bound that is not known stays open, and
+// saturating at INT_MIN or INT_MAX leaves it open as well.
+VariableRange wideRanges(const VariableRange& lhs, const VariableRange& rhs, char op) {
+    bool lhs_open = lhs.min_value == INT_MIN || lhs.max_value == INT_MAX;
+    bool rhs_open = rhs.min_value == INT_MIN || rhs.max_value == INT_MAX;
+    switch (op) {
+        case '+': {
+            VariableRange output = IntervalKernel<'+'>::apply(lhs, rhs);
+            if (lhs.min_value == INT_MIN || rhs.min_value == INT_MIN) {
+                output.min_value = INT_MIN;
+            }
+            if (lhs.max_value == INT_MAX || rhs.max_value == INT_MAX) {
+                output.max_value = INT_MAX;
+            }
+            return output;
+        }
+        case '-': {
+            VariableRange output = IntervalKernel<'-'>::apply(lhs, rhs);
+            if (lhs.min_value == INT_MIN || rhs.max_value == INT_MAX) {
+                output.min_value = INT_MIN;
+            }
+            if (lhs.max_value == INT_MAX || rhs.min_value == INT_MIN) {
+                output.max_value = INT_MAX;
+            }
+            return output;
+        }
+        case '*':
+            return lhs_open || rhs_open ? VariableRange() : IntervalKernel<'*'>::apply(lhs, rhs);
+        case '/':
+            return lhs_open || rhs_open ? VariableRange() : IntervalKernel<'/'>::apply(lhs, rhs);
+        case '%':
+            // Bounded by the divisor, however large the dividend is
+            return IntervalKernel<'%'>::apply(lhs, rhs);
+        case 'u':
+            return IntervalKernel<'u'>::apply(lhs, rhs);
+        case 'd':
+            // At most the dividend, whose bound stays open
+            return lhs.min_value < 0 || rhs.min_value < 0 ? VariableRange() : VariableRange{0, lhs.max_value};
+        case '&':
+        case '|':
+            // Only the signs and the bounds that are not open matter, an open bound stays open
+            return applyKernel(op, lhs, rhs);
+        default:
+            return VariableRange();
+    }
 }
 
-// If adding two variables, returns the new range when adding together.
-VariableRange subRanges(const VariableRange& lhs, const VariableRange& rhs) {
-    return checkAllCombinations(lhs, rhs, '-');
+// The int that stands for the constant value: itself if it fits an int, otherwise the bound on
+// its side, which stands for every value beyond it.
+int clampConstant(const APInt& value) {
+    if (value.getMinSignedBits() > 32) {
+        return value.isNegative() ? INT_MIN : INT_MAX;
+    }
+    return static_cast<int>(value.getSExtValue());
 }
 
-// Multiplying two ranges, returns the new range when multiplying together.
-VariableRange multRanges(const VariableRange& lhs, const VariableRange& rhs) {
-    return checkAllCombinations(lhs, rhs, '*');
+// The range of a zext of a value of from_bits bits. Negative values become the large unsigned
+// values of that width.
+VariableRange zextRange(const VariableRange& range, unsigned from_bits) {
+    if (range.min_value >= 0) {
+        return range;
+    }
+
+    // Any i1 that is not 0 is 1, it is tracked as -1
+    if (from_bits >= 31) {
+        return {0, INT_MAX};
+    }
+    return {0, static_cast<int>((1u << from_bits) - 1)};
+}
+
+// The range of a trunc of a value of from_bits bits to to_bits bits. Values that do not fit the
+// result are cut to its bits, anything the signed result holds is possible then.
+VariableRange truncRange(const VariableRange& range, unsigned from_bits, unsigned to_bits) {
+    long long smallest = to_bits >= 32 ? INT_MIN : -(1ll << (to_bits - 1));
+    long long largest = to_bits >= 32 ? INT_MAX : (1ll << (to_bits - 1)) - 1;
+
+    // Bounds of a wide value may stand for values beyond the result
+    bool open = from_bits > 32 && (range.min_value == INT_MIN || range.max_value == INT_MAX);
+    if (!open && range.min_value >= smallest && range.max_value <= largest) {
+        return range;
+    }
+    return {static_cast<int>(smallest), static_cast<int>(largest)};
 }
 
-// Dividing two ranges, returns the new range when dividing together.
-VariableRange divRanges(const VariableRange& lhs, const VariableRange& rhs) {
-    if (rhs.min_value == 0 && rhs.max_value == 0) {
-        errs() << "ERROR: Divide by 0 attempted, exitting.\n";
-        exit(1);
+// The range of a result of bits bits computed as if it did not wrap. Integers narrower than an
+// int wrap within their own bits, if the range does not fit it may be any value of them.
+VariableRange fitRange(const VariableRange& range, unsigned bits) {
+    if (bits >= 32) {
+        return range;
     }
 
-    return checkAllCombinations(lhs, rhs, '/');
+    int smallest = static_cast<int>(-(1ll << (bits - 1)));
+    int largest = static_cast<int>((1ll << (bits - 1)) - 1);
+    if (range.min_value >= smallest && range.max_value <= largest) {
+        return range;
+    }
+    return {smallest, largest};
 }
 
 // Make sure the range makes sense, min is less than max
@@ -176,8 +511,10 @@ bool validate(const VariableRange& range) {
 // Returns the range if lhs < rhs for lhs
 // If this range is not possible, for example [3, 4] < [1, 3], the successful is false
 VariableRange lessRange(const VariableRange& lhs, const VariableRange& rhs, bool& successful) {
+    // A bound of INT_MIN or INT_MAX may stand for wider values, nothing is known past it
     VariableRange output = lhs;
-    output.max_value = min(rhs.max_value - 1, lhs.max_value);
+    int bound = rhs.max_value == INT_MAX || rhs.max_value == INT_MIN ? rhs.max_value : rhs.max_value - 1;
+    output.max_value = min(bound, lhs.max_value);
 
     if (validate(output)) {
         successful = true;
@@ -207,7 +544,8 @@ VariableRange lessEqualRange(const VariableRange& lhs, const VariableRange& rhs,
 // Returns the range if lhs > rhs for lhs
 VariableRange greaterRange(const VariableRange& lhs, const VariableRange& rhs, bool& successful) {
     VariableRange output = lhs;
-    output.min_value = min(rhs.min_value + 1, lhs.max_value);
+    int bound = rhs.min_value == INT_MIN || rhs.min_value == INT_MAX ? rhs.min_value : rhs.min_value + 1;
+    output.min_value = min(bound, lhs.max_value);
 
     if (validate(output)) {
         successful = true;
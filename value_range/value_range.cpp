@@ -1,4 +1,10 @@
 // LLVM Includes
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/Pass.h"
 #include "llvm/IR/Function.h"
@@ -7,21 +13,59 @@
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
-#include "llvm/Analysis/BlockFrequencyInfo.h"
-#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/LoopUtils.h"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/CallGraph.h"
 #include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpander.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/DebugLoc.h"
 #include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/IR/PassTimingInfo.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/PassPlugin.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/Timer.h"
+#if LLVM_VERSION_MAJOR >= 11
+#include "llvm/Support/TimeProfiler.h"
+#endif
 
 // Personal Includes
+#include "BoundsCheck.h"
+#include "RangeKernels.h"
+#include "Ranges.h"
+#include "ResultCache.h"
+#include "ValueRangeAnalysis.h"
 #include "VariableRange.h"
 
 // STL includes
 #include <cassert>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <queue>
+#include <thread>
 #include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -29,44 +73,221 @@
 using namespace llvm;
 
 using std::cerr;
+using std::greater;
 using std::max;
 using std::min;
 using std::pair;
-using std::queue;
+using std::priority_queue;
+using std::unique_ptr;
 using std::unordered_map;
-using std::unordered_set;
 using std::vector;
 
-// Definition of a range for an instruction, we map the value to its range
-typedef unordered_map<Value*, VariableRange> Ranges;
+#define DEBUG_TYPE "bounds-check"
 
 #define INT_SIZE 32
 
+static cl::opt<RangeKernelLevel> SIMDKernels(
+    "bounds-check-simd", cl::init(KERNELS_AUTO),
+    cl::desc("Instruction set used to join, widen and compare range states"),
+    cl::values(clEnumValN(KERNELS_AUTO, "auto", "Best one the host supports"),
+               clEnumValN(KERNELS_SCALAR, "scalar", "Portable scalar loops"),
+               clEnumValN(KERNELS_SSE41, "sse4.1", "SSE4.1, 4 intervals at once"),
+               clEnumValN(KERNELS_AVX2, "avx2", "AVX2, 8 intervals at once")));
+
+static cl::opt<bool> EliminateChecks(
+    "BoundsCheck-eliminate", cl::init(false),
+    cl::desc("Remove runtime bounds checks the ranges prove can never fail"));
+
+static cl::opt<bool> GuardAccesses(
+    "BoundsCheck-guard", cl::init(false),
+    cl::desc("Guard the array accesses that are not proven in bounds with a runtime check"));
+
+static cl::opt<bool> HoistGuards(
+    "BoundsCheck-hoist", cl::init(true),
+    cl::desc("In guard mode, check affine indices of a loop once before it and version the loop"));
+
+static cl::opt<bool> AnnotateRanges(
+    "BoundsCheck-annotate", cl::init(false),
+    cl::desc("Attach the ranges to the IR as !range metadata, nsw/nuw flags and llvm.assume calls"));
+
+static cl::opt<bool> RelationalChecks(
+    "BoundsCheck-relational", cl::init(false),
+    cl::desc("Prove the accesses the ranges leave open with differences between the values of their guards"));
+
+static cl::opt<bool> ProfileGuided(
+    "BoundsCheck-profile", cl::init(false),
+    cl::desc("Use block frequencies and profile counts to solve hot blocks first, hoist guards only out of hot "
+             "loops and rank the findings"));
+
+// Weight of the in bounds side of a guard, the trap side has weight 1
+#define GUARD_LIKELY_WEIGHT 2000
+
+STATISTIC(NumCacheHits, "Number of functions whose result was read from the cache");
+STATISTIC(NumCacheMisses, "Number of functions analyzed and written to the cache");
+STATISTIC(NumFunctionsAnalyzed, "Number of functions analyzed");
+STATISTIC(NumBlocksVisited, "Number of basic blocks the solvers visited");
+STATISTIC(NumSolverIterations, "Number of solver visits, blocks in memory mode and instructions in SSA mode");
+STATISTIC(NumInstructionsTransferred, "Number of instructions whose effect on the ranges was computed");
+STATISTIC(NumWidenings, "Number of times a loop header state or phi was widened");
+STATISTIC(NumAccessesChecked, "Number of array accesses into arrays of known size");
+STATISTIC(NumAccessesUnknown, "Number of array accesses neither proven in bounds nor out of bounds");
+STATISTIC(NumFunctionsGivenUp, "Number of functions whose ranges were given up for exceeding a budget");
+STATISTIC(NumValuesAnnotated, "Number of values whose range was written into the IR");
+STATISTIC(NumChecksEliminated, "Number of runtime bounds checks removed");
+STATISTIC(NumAccessesProvenSafe, "Number of array accesses proven in bounds");
+STATISTIC(NumAccessesGuarded, "Number of array accesses guarded at runtime");
+STATISTIC(NumAccessesOutOfBounds, "Number of array accesses always out of bounds");
+STATISTIC(NumInductionVariablesSeeded, "Number of induction variables seeded from scalar evolution");
+STATISTIC(NumGuardsHoisted, "Number of guards checked once before their loop");
+STATISTIC(NumArgumentsBounded, "Number of function arguments bounded by all of their call sites");
+STATISTIC(NumLoopsVersioned, "Number of loops split into an unchecked and a checked copy");
+STATISTIC(NumAccessesProvenRelational, "Number of array accesses proven in bounds by differences, not by ranges");
+STATISTIC(NumFunctionsSkipped, "Number of functions without array accesses the demand-driven mode skipped");
+
+static cl::opt<bool> WholeProgram(
+    "bounds-check-whole-program", cl::init(false),
+    cl::desc("Interprocedural mode: every function but main is only called from within the module"));
+
+static cl::opt<unsigned> SummaryRounds(
+    "bounds-check-summary-rounds", cl::init(4),
+    cl::desc("Rounds over the call graph before argument ranges that do not hold are given up"));
+
+static cl::opt<unsigned> Threads(
+    "bounds-check-threads", cl::init(1),
+    cl::desc("Threads the interprocedural mode solves independent functions on, 0 for one per core"));
+
+static cl::opt<std::string> CacheDirectory(
+    "bounds-check-cache-dir", cl::init(""),
+    cl::desc("Directory the results of unchanged functions are reused from, no cache if empty"));
+
+static cl::opt<BoundsCheckReport::Format> ReportFormat(
+    "bounds-check-format", cl::init(BoundsCheckReport::FORMAT_TEXT),
+    cl::desc("Format the findings are written in"),
+    cl::values(clEnumValN(BoundsCheckReport::FORMAT_TEXT, "text", "Warnings about the accesses always out of bounds"),
+               clEnumValN(BoundsCheckReport::FORMAT_JSON_LINES, "jsonl",
+                          "A JSON object per line for every access not proven in bounds and every module"),
+               clEnumValN(BoundsCheckReport::FORMAT_SARIF, "sarif", "A SARIF 2.1.0 log, a run per module")));
+
+static cl::opt<std::string> ReportFile(
+    "bounds-check-output", cl::init("-"),
+    cl::desc("File the findings are written to, - for stderr"));
+
+static cl::opt<unsigned> MaxRelatedValues(
+    "bounds-check-related-values", cl::init(8),
+    cl::desc("Values the differences of one access relate in -BoundsCheck-relational, the closure is cubic in them"));
+
+static cl::opt<bool> DemandDriven(
+    "bounds-check-demand-driven", cl::init(false),
+    cl::desc("Only track the values array indices and compares depend on, skip functions without array accesses"));
+
+static cl::opt<unsigned> HotFrequency(
+    "bounds-check-hot-frequency", cl::init(4),
+    cl::desc("Times per call of its function a block runs at least to be hot in -BoundsCheck-profile"));
+
+// Functions prepared per thread before they are solved at once, bounds the analyses kept alive
+#define FUNCTIONS_PER_THREAD 4
+
+static cl::opt<unsigned> MaxSolverIterations(
+    "bounds-check-max-iterations", cl::init(1000000),
+    cl::desc("Solver visits per function before its ranges are given up, 0 for no limit"));
+
+static cl::opt<unsigned> MaxTrackedValues(
+    "bounds-check-max-values", cl::init(200000),
+    cl::desc("Values a function may have before it is not analyzed at all, 0 for no limit"));
+
+static cl::opt<unsigned> TimeLimit(
+    "bounds-check-time-limit", cl::init(0),
+    cl::desc("Milliseconds the solver may spend on a function before its ranges are given up, 0 for no limit"));
+
+// Solver visits between two looks at the clock
+#define TIME_CHECK_INTERVAL 1024
+
+static cl::opt<unsigned> NarrowingRounds(
+    "bounds-check-narrowing", cl::init(2),
+    cl::desc("Rounds without widening once the solver converged, to tighten loop bounds again"));
+
+// How variables reach the analysis
+enum AnalysisMode {
+    MODE_AUTO,
+    MODE_MEMORY,
+    MODE_SSA
+};
+
+static cl::opt<AnalysisMode> Mode(
+    "bounds-check-mode", cl::init(MODE_AUTO),
+    cl::desc("Form of the IR the range analysis expects"),
+    cl::values(clEnumValN(MODE_AUTO, "auto", "SSA once no scalar allocas are left, memory otherwise"),
+               clEnumValN(MODE_MEMORY, "memory", "Variables are loaded from and stored to allocas (-O0)"),
+               clEnumValN(MODE_SSA, "ssa", "Variables are SSA values and phi nodes (after mem2reg)")));
+
 // LLVM recommends anonymous namespaces
 namespace {
     /*
      * Description:
-     * Given set of variable ranges, determine if they are equal. Being equal is defined as having
-     * the same values stored and all of the values have the same range.
+     * The report the passes write to, opened on first use: stderr, or the file -bounds-check-output
+     * names. The structured formats are always buffered, the text warnings on stderr are not. A
+     * SARIF log is closed when the process exits.
      */
-    bool equal_ranges(Ranges& first, Ranges& second) {
-        if (first.size() != second.size()) {
-            return false;
-        }
+    class PassReport {
+    public:
+        PassReport() {
+            raw_ostream* os = &errs();
+            if (ReportFile != "-") {
+                std::error_code error;
+#if LLVM_VERSION_MAJOR >= 10
+                file.reset(new raw_fd_ostream(ReportFile, error, sys::fs::OF_Text));
+#else
+                file.reset(new raw_fd_ostream(ReportFile, error, sys::fs::F_Text));
+#endif
+                if (error) {
+                    errs() << ReportFile << ": " << error.message() << ", reporting to stderr instead\n";
+                    file.reset();
+                }
+            }
+            if (!file && ReportFormat != BoundsCheckReport::FORMAT_TEXT) {
+                file.reset(new raw_fd_ostream(STDERR_FILENO, false));
+            }
+            if (file) {
+                os = file.get();
+            }
 
-        // Iterate through all of first and check if it exists in second with the same range
-        for (auto& range : first) {
-            Value* val = range.first;
-            VariableRange& varRange = range.second;
-            if (!second.count(val)) {
-                return false;
+            if (ReportFormat == BoundsCheckReport::FORMAT_SARIF) {
+                BoundsCheckReport::beginSARIF(*os);
             }
+            report.reset(new BoundsCheckReport(*os, ReportFormat));
+        }
 
-            if (second[val].min_value != varRange.min_value || second[val].max_value != varRange.max_value) {
-                return false;
+        ~PassReport() {
+            raw_ostream& os = report->getStream();
+            report.reset();
+            if (ReportFormat == BoundsCheckReport::FORMAT_SARIF) {
+                BoundsCheckReport::endSARIF(os);
             }
+            os.flush();
         }
-        return true;
+
+        BoundsCheckReport& get() {
+            return *report;
+        }
+
+    private:
+        unique_ptr<raw_fd_ostream> file;
+        unique_ptr<BoundsCheckReport> report;
+    };
+
+    BoundsCheckReport& getPassReport() {
+        static PassReport pass_report;
+        return pass_report.get();
+    }
+
+    /*
+     * Description:
+     * Given set of variable ranges, determine if they are equal. Being equal is defined as having
+     * the same values stored and all of the values have the same range.
+     */
+    bool equal_ranges(const Ranges& first, const Ranges& second) {
+        // Different hashes decide it at once, equal ones fall back to a scan over the dense states
+        return first == second;
     }
 
     /*
@@ -75,65 +296,376 @@ namespace {
      * value is removed. If they exist in both, the resulting range encapsulates both ranges.
      */
     void intersectRanges(Ranges& orig, const Ranges& to_merge) {
-        // Union all ranges that exist in to_merge and orig together.
-        for (const auto& value_range : to_merge) {
-            Value* value = value_range.first;
-            const VariableRange& range = value_range.second;
-            if (orig.count(value)) {
-                orig[value] = unionRange(orig[value], range);
-            }
-        }
+        // Slot by slot, the live bits are intersected and each range is the union of both ranges
+        orig.join(to_merge);
+    }
 
-        // Find all values that are in orig but not in to_merge
-        vector<Value*> victims;
-        for (auto& value_range : orig) {
-            Value* value = value_range.first;
-            if (!to_merge.count(value)) {
-                victims.push_back(value);
-            }
-        }
+    /*
+     * Description:
+     * What the interprocedural analysis knows about a function: the ranges it was analyzed with for
+     * its arguments, and the range of every value it returns given those arguments.
+     */
+    struct FunctionSummary {
+        vector<VariableRange> arguments;
+        VariableRange returned;
 
-        // Remove all vals that are not in to_merge
-        for (Value* val : victims) {
-            orig.erase(val);
-        }
-    }
+        // Is returned known, false until the function was analyzed in the current round
+        bool solved = false;
+    };
+
+    typedef unordered_map<Function*, FunctionSummary> SummaryMap;
+
+    /*
+     * Description:
+     * Times a phase of the analysis for -time-passes and, from LLVM 11 on, for -ftime-trace. Older
+     * time profilers are not thread safe, and neither is one timer started on several threads, so
+     * the timers are off unless enabled, which the analyzer only is on a single thread.
+     */
+    class PhaseTimer {
+    public:
+        PhaseTimer(StringRef name, StringRef description, bool enabled)
+            : timer(name, description, "bounds-check", "Bounds Check Pass", enabled)
+#if LLVM_VERSION_MAJOR >= 11
+            , trace(name)
+#endif
+        {}
+
+    private:
+        NamedRegionTimer timer;
+#if LLVM_VERSION_MAJOR >= 11
+        TimeTraceScope trace;
+#endif
+    };
 
     /*
      * Description:
-     * A function pass that checks the bounds of statically allocated arrays.
+     * Computes the value ranges of a function and checks the bounds of statically allocated arrays
+     * with them. The legacy pass and the new pass manager analysis both run it, the checks and
+     * transforms work on what it found.
      * 
      * Requirements:
-     * 1. Only integer variables
-     * 2. No dynamically allocated arrays
+     * 1. Only integer variables, values wider than an int are clamped to the int range
+     * 2. Heap arrays come from malloc, calloc or new[], their size is the fewest bytes requested
      * 3. No integer overflow
      * 4. Boolean conditions only depend on variables and constants
-     * 5. Binary operators are restricted to +, -, *, /
+     * 5. Binary operators are restricted to add, sub, mul, sdiv, udiv, srem, urem, shl, ashr, and
+     *    and or, anything else could be any value
+     * 6. Locals whose address escapes and values in memory could hold anything
      */
-    struct BoundsCheckPass : public FunctionPass {
-        // ================== BEGIN LLVM PASS INFO ================== //
-        
-        static char ID;
-        BoundsCheckPass() : FunctionPass(ID) {}
+    class RangeAnalyzer {
+    public:
+        // ================== BEGIN VALUE RANGE ANALYSIS ================== //
 
-        // Necessary for LLVM Passes
-        void getAnalysisUsage(AnalysisUsage &AU) const {
-            AU.setPreservesAll();
-        }
+        /*
+         * Description:
+         * Did the solver exceed its budget of visits or time on the current function. Gives up on
+         * the function if so, the solvers stop as soon as they see it.
+         */
+        bool overBudget() {
+            if (state->gave_up) {
+                return true;
+            }
 
-        // ================== END LLVM PASS INFO ================== //
+            unsigned iterations = state->solver_iterations;
+            bool over = MaxSolverIterations && iterations > MaxSolverIterations;
+            // The SSA solver counts several visits at once, so it may step over every multiple
+            if (!over && TimeLimit && iterations - state->last_time_check >= TIME_CHECK_INTERVAL) {
+                state->last_time_check = iterations;
+                auto elapsed = std::chrono::steady_clock::now() - state->start_time;
+                over = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() > TimeLimit;
+            }
 
-        // ================== BEGIN VALUE RANGE ANALYSIS ================== //
+            if (over) {
+                giveUp();
+            }
+            return over;
+        }
+
+        /*
+         * Description:
+         * Forgets everything found so far: every value may be anything and every block may be
+         * reached, so every access is unproven.
+         */
+        void giveUp() {
+            state->gave_up = true;
+            clearWorklists();
+            ++NumFunctionsGivenUp;
+            LLVM_DEBUG(dbgs() << "BoundsCheck: over budget after " << state->solver_iterations
+                              << " visits, nothing is known\n");
+        }
 
         /*
          * Description:
-         * Creates a successor map so for each basic block, we know all successors.
+         * Gives every value that can have a range a dense index, so the ranges at a program point
+         * are a flat array instead of a hash map.
          */
-        void createSuccessorMap(Function& F) {
+        void numberValues(Function& F) {
+            if (state->demand_driven) {
+                numberSlice(F);
+                return;
+            }
+
+            for (Argument& arg : F.args()) {
+                state->numbering.number(&arg);
+            }
+
             for (BasicBlock& BB : F) {
-                for (BasicBlock* pred : predecessors(&BB)) {
-                    bb_succs[pred].push_back(&BB);
+                for (Instruction& I : BB) {
+                    // Allocas stand for their stored value, everything else for its result
+                    if (isa<AllocaInst>(&I) || !I.getType()->isVoidTy()) {
+                        state->numbering.number(&I);
+                    }
+                }
+            }
+        }
+
+        /*
+         * Description:
+         * The demand-driven numberValues: only numbers the values the indices of array accesses,
+         * compares and switches depend on, the rest are never tracked and could be anything.
+         * Values flow into a local through its stores. With summaries, returned values and call
+         * arguments are needed as well.
+         */
+        void numberSlice(Function& F) {
+            vector<Value*> worklist;
+            for (Instruction& I : instructions(F)) {
+                GetElementPtrInst* gep = dyn_cast<GetElementPtrInst>(&I);
+                if (gep) {
+                    vector<ArrayIndex> indices;
+                    getArrayIndices(gep, indices);
+                    for (const ArrayIndex& index : indices) {
+                        worklist.push_back(gep->getOperand(index.operand));
+                    }
+
+                    CallInst* allocation = getAllocationCall(gep->getPointerOperand());
+                    if (allocation) {
+                        worklist.push_back(gep->getOperand(1));
+                        worklist.insert(worklist.end(), allocation->arg_begin(), allocation->arg_end());
+                    }
+                    state->has_array_accesses |= allocation || !indices.empty();
+                }
+                else if (isa<ICmpInst>(&I) || isa<SwitchInst>(&I)) {
+                    // Switches and compares decide which blocks are reached
+                    worklist.insert(worklist.end(), I.op_begin(), I.op_end());
+                    worklist.push_back(&I);
+                }
+                else if (summaries && (isa<ReturnInst>(&I) || isa<CallInst>(&I))) {
+                    worklist.insert(worklist.end(), I.op_begin(), I.op_end());
+                }
+            }
+
+            SmallPtrSet<Value*, 32> slice;
+            while (!worklist.empty()) {
+                Value* val = worklist.back();
+                worklist.pop_back();
+                if ((!isa<Instruction>(val) && !isa<Argument>(val)) || !slice.insert(val).second) {
+                    continue;
+                }
+
+                Instruction* inst = dyn_cast<Instruction>(val);
+                if (!inst || isa<GetElementPtrInst>(inst)) {
+                    // Nothing is assumed about values in arrays
+                    continue;
+                }
+
+                if (LoadInst* load = dyn_cast<LoadInst>(inst)) {
+                    worklist.push_back(load->getPointerOperand());
+                }
+                else if (isa<AllocaInst>(inst)) {
+                    for (User* user : inst->users()) {
+                        StoreInst* store = dyn_cast<StoreInst>(user);
+                        if (store && store->getPointerOperand() == inst) {
+                            worklist.push_back(store->getValueOperand());
+                        }
+                    }
+                }
+                else if (isa<SelectInst>(inst)) {
+                    worklist.push_back(inst->getOperand(1));
+                    worklist.push_back(inst->getOperand(2));
+                }
+                else if (CallInst* call = dyn_cast<CallInst>(inst)) {
+                    // Only the summary of the callee looks at the arguments
+                    if (hasSummary(call)) {
+                        worklist.insert(worklist.end(), call->arg_begin(), call->arg_end());
+                    }
+                }
+                else {
+                    worklist.insert(worklist.end(), inst->op_begin(), inst->op_end());
+                }
+            }
+
+            for (Argument& arg : F.args()) {
+                if (slice.count(&arg)) {
+                    state->numbering.number(&arg);
+                }
+            }
+            for (Instruction& I : instructions(F)) {
+                if (slice.count(&I) && (isa<AllocaInst>(&I) || !I.getType()->isVoidTy())) {
+                    state->numbering.number(&I);
+                }
+            }
+        }
+
+        /*
+         * Description:
+         * Does the demand-driven solver have to look at inst: terminators steer it, the others only
+         * matter if they define or store to a value of the slice.
+         */
+        bool isDemanded(Instruction* inst) {
+            if (inst->isTerminator()) {
+                return true;
+            }
+            StoreInst* store = dyn_cast<StoreInst>(inst);
+            return state->numbering.contains(store ? store->getPointerOperand() : inst);
+        }
+
+        /*
+         * Description:
+         * Is the address of the local alloca used for anything but loading and storing its value,
+         * like passing it to scanf or storing it to a pointer. Anything could write to it then,
+         * without a store of the function to it. Lifetime markers do not count.
+         */
+        bool isEscaped(AllocaInst* alloca) {
+            for (User* user : alloca->users()) {
+                LoadInst* load = dyn_cast<LoadInst>(user);
+                StoreInst* store = dyn_cast<StoreInst>(user);
+                if ((load && load->getPointerOperand() == alloca) ||
+                    (store && store->getPointerOperand() == alloca && store->getValueOperand() != alloca) ||
+                    isLifetimeMarker(user)) {
+                    continue;
+                }
+
+                // Clang casts the address to i8* for the lifetime markers
+                BitCastInst* cast = dyn_cast<BitCastInst>(user);
+                if (cast && std::all_of(cast->user_begin(), cast->user_end(), [this](User* cast_user) {
+                        return isLifetimeMarker(cast_user);
+                    })) {
+                    continue;
+                }
+                return true;
+            }
+            return false;
+        }
+
+        bool isLifetimeMarker(User* user) {
+            IntrinsicInst* intrinsic = dyn_cast<IntrinsicInst>(user);
+            return intrinsic && (intrinsic->getIntrinsicID() == Intrinsic::lifetime_start ||
+                                 intrinsic->getIntrinsicID() == Intrinsic::lifetime_end);
+        }
+
+        /*
+         * Description:
+         * Finds the scalar locals of F whose address escapes. Memory mode knows nothing about the
+         * values loaded from them, the range of their last store may be stale.
+         */
+        void collectEscapedAllocas(Function& F) {
+            for (Instruction& I : instructions(F)) {
+                AllocaInst* alloca = dyn_cast<AllocaInst>(&I);
+                if (alloca && !alloca->getAllocatedType()->isArrayTy() && isEscaped(alloca)) {
+                    state->escaped_allocas.insert(alloca);
+                }
+            }
+        }
+
+        /*
+         * Description:
+         * Numbers the basic blocks reachable from the entry in reverse post-order. The worklist
+         * always visits the block with the lowest number first, so a block is normally only
+         * visited after all of its forward predecessors. With block frequencies, the hotter
+         * successor of a branch is numbered first.
+         */
+        void createBlockOrder(Function& F) {
+            if (block_frequency) {
+                vector<BasicBlock*> post_order = getHotPostOrder(F);
+                state->rpo_blocks.assign(post_order.rbegin(), post_order.rend());
+            }
+            else {
+                ReversePostOrderTraversal<Function*> rpot(&F);
+                state->rpo_blocks.assign(rpot.begin(), rpot.end());
+            }
+
+            for (unsigned i = 0; i < state->rpo_blocks.size(); ++i) {
+                state->rpo_index[state->rpo_blocks[i]] = i;
+            }
+            state->in_worklist.assign(state->rpo_blocks.size(), false);
+        }
+
+        /*
+         * Description:
+         * The blocks reachable from the entry in post-order. The depth-first search follows the
+         * colder successors first, they finish first and so come after the hotter ones once the
+         * order is reversed.
+         */
+        vector<BasicBlock*> getHotPostOrder(Function& F) {
+            vector<BasicBlock*> post_order;
+            SmallPtrSet<BasicBlock*, 32> visited;
+            vector<pair<BasicBlock*, vector<BasicBlock*> > > stack;
+
+            auto enter = [&](BasicBlock* BB) {
+                visited.insert(BB);
+                vector<BasicBlock*> successors(succ_begin(BB), succ_end(BB));
+                std::stable_sort(successors.begin(), successors.end(), [&](BasicBlock* a, BasicBlock* b) {
+                    return block_frequency->getBlockFreq(a).getFrequency() >
+                           block_frequency->getBlockFreq(b).getFrequency();
+                });
+                stack.push_back({BB, successors});
+            };
+
+            // Successors are taken from the back, the coldest one first
+            enter(&F.getEntryBlock());
+            while (!stack.empty()) {
+                vector<BasicBlock*>& successors = stack.back().second;
+                if (successors.empty()) {
+                    post_order.push_back(stack.back().first);
+                    stack.pop_back();
+                    continue;
                 }
+
+                BasicBlock* next = successors.back();
+                successors.pop_back();
+                if (!visited.count(next)) {
+                    enter(next);
+                }
+            }
+            return post_order;
+        }
+
+        /*
+         * Description:
+         * Estimated number of times BB runs: its count in the profile if there is one, otherwise
+         * its frequency relative to the entry, so per call of the function.
+         */
+        uint64_t getExecutionCount(BasicBlock* BB) {
+            auto count = block_frequency->getBlockProfileCount(BB);
+            if (count) {
+                return *count;
+            }
+            return block_frequency->getBlockFreq(BB).getFrequency() / max<uint64_t>(block_frequency->getEntryFreq(), 1);
+        }
+
+        /*
+         * Description:
+         * Does BB run at least HotFrequency times per call of its function. Blocks the profile never
+         * saw running are cold whatever the static estimate says.
+         */
+        bool isHot(BasicBlock* BB) {
+            auto count = block_frequency->getBlockProfileCount(BB);
+            if (count && !*count) {
+                return false;
+            }
+            return block_frequency->getBlockFreq(BB).getFrequency() >=
+                   HotFrequency * block_frequency->getEntryFreq();
+        }
+
+        /*
+         * Description:
+         * Queues BB to be visited by the solver, unless it is already waiting to be visited.
+         */
+        void pushWorklist(BasicBlock* BB) {
+            auto index = state->rpo_index.find(BB);
+            if (index != state->rpo_index.end() && !state->in_worklist[index->second]) {
+                state->in_worklist[index->second] = true;
+                state->worklist.push(index->second);
             }
         }
 
@@ -142,12 +674,11 @@ namespace {
          * Initializes value stored at alloca with [INT_MIN, INT_MAX] in ranges
          */
         void handleAlloca(Instruction* inst, Ranges& ranges) {
-            assert(!ranges.count(inst));
             AllocaInst* alloc = dyn_cast<AllocaInst>(inst);
 
             // We ignore arrays, nothing is assumed about their stored values
             if (!alloc->getAllocatedType()->isArrayTy()) {
-                ranges[alloc] = {INT_MIN, INT_MAX};
+                ranges.set(alloc, {INT_MIN, INT_MAX});
             }
         }
 
@@ -157,10 +688,14 @@ namespace {
          */
         void handleLoad(Instruction* inst, Ranges& ranges) {
             LoadInst* load = dyn_cast<LoadInst>(inst);
-            assert(ranges.count(load->getPointerOperand()));
 
-            // Loading from a pointer, just use the same range.
-            ranges[load] = ranges[load->getPointerOperand()];
+            // Loading from a pointer, just use the same range. Globals and other untracked memory,
+            // and escaped locals that may have been written behind our back, could hold anything.
+            if (state->escaped_allocas.count(load->getPointerOperand())) {
+                ranges.set(load, VariableRange());
+                return;
+            }
+            ranges.set(load, ranges.get(load->getPointerOperand()));
         }
 
         /*
@@ -169,17 +704,16 @@ namespace {
          */
         void handleStore(Instruction* inst, Ranges& ranges) {
             StoreInst* store = dyn_cast<StoreInst>(inst);
-            assert(ranges.count(store->getPointerOperand()));
 
-            // If it is a constant, c, update the range to be [c, c]. Else, use whatever known range
+            // If it is a constant, c, update the range to be [c, c]. Else, use whatever known range,
+            // values without one could be anything.
             if (isa<ConstantInt>(store->getValueOperand())) {
                 ConstantInt* constant = dyn_cast<ConstantInt>(store->getValueOperand());
-                ranges[store->getPointerOperand()].min_value = static_cast<int>(constant->getSExtValue());
-                ranges[store->getPointerOperand()].max_value = static_cast<int>(constant->getSExtValue());
+                int val = clampConstant(constant->getValue());
+                ranges.set(store->getPointerOperand(), {val, val});
             }
             else {
-                assert(ranges.count(store->getValueOperand()));
-                ranges[store->getPointerOperand()] = ranges[store->getValueOperand()];
+                ranges.set(store->getPointerOperand(), ranges.get(store->getValueOperand()));
             }
         }
 
@@ -194,97 +728,57 @@ namespace {
             VariableRange firstRange;
             VariableRange secondRange;
 
-            // If it is a constant, c, retrieve range [c,c], else get already stored range.
+            // If it is a constant, c, retrieve range [c,c], else get already stored range. Operands
+            // without one, like the compares the bitwise operators combine, could be anything.
             if (isa<ConstantInt>(first)) {
                 ConstantInt* firstConst = dyn_cast<ConstantInt>(first);
-                int val = static_cast<int>(firstConst->getSExtValue());
+                int val = clampConstant(firstConst->getValue());
                 firstRange.min_value = val;
                 firstRange.max_value = val;
             }
             else {
-                assert(ranges.count(first));
-                firstRange = ranges[first];
+                firstRange = ranges.get(first);
             }
 
             if (isa<ConstantInt>(second)) {
                 ConstantInt* secondConst = dyn_cast<ConstantInt>(second);
-                int val = static_cast<int>(secondConst->getSExtValue());
+                int val = clampConstant(secondConst->getValue());
                 secondRange.min_value = val;
                 secondRange.max_value = val;
             }
             else {
-                assert(ranges.count(second));
-                secondRange = ranges[second];
+                secondRange = ranges.get(second);
             }
 
-            // Depending on operation, calculate the new range.
-            switch(op) {
-                case '+' :
-                    ranges[inst] = addRanges(firstRange, secondRange);
-                    break;
-                case '-':
-                    ranges[inst] = subRanges(firstRange, secondRange);
-                    break;
-                case '/':
-                    ranges[inst] = divRanges(firstRange, secondRange);
-                    break;
-                case '*':
-                    ranges[inst] = multRanges(firstRange, secondRange);
-                    break;
-                default :
-                    errs() << "ERROR: Unexpected binary operation.\nExitting\n";
-                    exit(1); 
-            }
+            ranges.set(inst, binaryRange(firstRange, secondRange, op, getBits(inst)));
         }
 
         /*
          * Description:
-         * Determine the new if_range and else_range depending on if the icmp results in true or false.
-         * If it is not possible to reach the specific BB from this BB, we say it is not reachable.
+         * The range of the result of the binary op on firstRange and secondRange, of values of
+         * bits bits. Values wider than an int have open bounds, narrower ones wrap within their bits.
          */
-        void handleICMP(ICmpInst* icmp, Ranges& if_ranges, Ranges& else_ranges, bool& if_reachable, bool& else_reachable) {
-            assert(equal_ranges(if_ranges, else_ranges));
-
-            Value* firstVal = icmp->getOperand(0);
-            Value* secondVal = icmp->getOperand(1);
-
-            VariableRange first;
-            VariableRange second;
-
-            bool firstConst = false;
-            bool secondConst = false;
-
-            // Determine what the first and second range we are calculating for.
-            if (isa<ConstantInt>(firstVal)) {
-                ConstantInt* constant = dyn_cast<ConstantInt>(firstVal);
-                int val = static_cast<int>(constant->getSExtValue());
-                first.min_value = val;
-                first.max_value = val;
-                firstConst = true;
-            }
-            else {
-                assert(if_ranges.count(firstVal));
-                assert(isa<LoadInst>(firstVal));
-                first = if_ranges[firstVal];
-            }
-
-            if (isa<ConstantInt>(secondVal)) {
-                ConstantInt* constant = dyn_cast<ConstantInt>(secondVal);
-                int val = static_cast<int>(constant->getSExtValue());
-                second.min_value = val;
-                second.max_value = val;
-                secondConst = true;
-            }
-            else {
-                assert(if_ranges.count(secondVal));
-                assert(isa<LoadInst>(secondVal));
-                second = if_ranges[secondVal];
+        VariableRange binaryRange(const VariableRange& firstRange, const VariableRange& secondRange, char op,
+                                  unsigned bits) {
+            if (bits > INT_SIZE) {
+                return wideRanges(firstRange, secondRange, op);
             }
 
-            VariableRange if_lhs, if_rhs, else_lhs, else_rhs;
+            // Nothing is known about operations the ranges do not model
+            return fitRange(applyKernel(op, firstRange, secondRange), bits);
+        }
 
+        /*
+         * Description:
+         * Determine the ranges of both operands of a compare with predicate in the case it is true
+         * (if_lhs, if_rhs) and in the case it is false (else_lhs, else_rhs). If the compare can
+         * never be true or never be false, the corresponding reachable flag is false.
+         */
+        void refineCompare(CmpInst::Predicate predicate, const VariableRange& first, const VariableRange& second,
+                           VariableRange& if_lhs, VariableRange& if_rhs, VariableRange& else_lhs,
+                           VariableRange& else_rhs, bool& if_reachable, bool& else_reachable) {
             // Iterate through all predicates to determine new ranges in if and else case
-            switch (icmp->getSignedPredicate()) {
+            switch (predicate) {
                 case CmpInst::Predicate::ICMP_EQ : // ==
                     if_lhs = equalRange(first, second, if_reachable);
                     if_rhs = if_lhs;
@@ -344,38 +838,141 @@ namespace {
                     }
                     break;
                 default:
-                    errs() << "ERROR: Unknown predicate in if statement.\nExitting.\n";
-                    exit(1);
+                    // Unsigned compares of possibly negative values refine nothing, both ways are open
+                    if_lhs = else_lhs = first;
+                    if_rhs = else_rhs = second;
+                    if_reachable = else_reachable = true;
+                    break;
             }
-            
-            // If either ranges were not constant, update the corresponding range
-            if (!firstConst) {
-                Value* inst = (dyn_cast<LoadInst>(firstVal))->getOperand(0);
-                if_ranges[inst] = if_lhs;
-                else_ranges[inst] = else_lhs;
+        }
+
+        /*
+         * Description:
+         * refineCompare for icmp. Unsigned compares agree with the signed ones when both operands are
+         * non-negative. Otherwise negative values are the largest unsigned ones, so only a value below
+         * a non-negative one is refined, it has to be non-negative as well.
+         */
+        void refineICmp(ICmpInst* icmp, const VariableRange& first, const VariableRange& second,
+                        VariableRange& if_lhs, VariableRange& if_rhs, VariableRange& else_lhs,
+                        VariableRange& else_rhs, bool& if_reachable, bool& else_reachable) {
+            if (!icmp->isUnsigned() || (first.min_value >= 0 && second.min_value >= 0)) {
+                refineCompare(icmp->getSignedPredicate(), first, second, if_lhs, if_rhs, else_lhs, else_rhs,
+                              if_reachable, else_reachable);
+                return;
             }
 
-            if (!secondConst) {
-                Value* inst = (dyn_cast<LoadInst>(secondVal))->getOperand(0);
-                if_ranges[inst] = if_rhs;
-                else_ranges[inst] = else_rhs;
+            if_lhs = else_lhs = first;
+            if_rhs = else_rhs = second;
+            if_reachable = else_reachable = true;
+
+            CmpInst::Predicate predicate = icmp->getPredicate();
+            CmpInst::Predicate signed_predicate = ICmpInst::getSignedPredicate(predicate);
+            VariableRange unused_lhs, unused_rhs;
+            bool unused_reachable;
+            if ((predicate == CmpInst::Predicate::ICMP_ULT || predicate == CmpInst::Predicate::ICMP_ULE) &&
+                second.min_value >= 0) {
+                if (first.max_value < 0) {
+                    if_reachable = false;
+                    return;
+                }
+                refineCompare(signed_predicate, {max(first.min_value, 0), first.max_value}, second, if_lhs, if_rhs,
+                              unused_lhs, unused_rhs, if_reachable, unused_reachable);
+            }
+            else if ((predicate == CmpInst::Predicate::ICMP_UGT || predicate == CmpInst::Predicate::ICMP_UGE) &&
+                     first.min_value >= 0) {
+                if (second.max_value < 0) {
+                    if_reachable = false;
+                    return;
+                }
+                refineCompare(signed_predicate, first, {max(second.min_value, 0), second.max_value}, if_lhs, if_rhs,
+                              unused_lhs, unused_rhs, if_reachable, unused_reachable);
             }
         }
 
         /*
          * Description:
-         * From the branch instruction, determine what the resulting range is for all successors of the basic block.
-         * Returns true if update was made.
+         * Determine the new if_range and else_range depending on if the icmp results in true or false.
+         * If it is not possible to reach the specific BB from this BB, we say it is not reachable.
          */
-        bool handleBranchInstruction(Instruction* inst, Ranges& ranges) {
-            BranchInst* branch = dyn_cast<BranchInst>(inst);
+        void handleICMP(ICmpInst* icmp, Ranges& if_ranges, Ranges& else_ranges, bool& if_reachable, bool& else_reachable) {
+            assert(equal_ranges(if_ranges, else_ranges));
 
-            // If it is conditional, determine how the icmp effects the cases.
-            if (branch->isConditional()) {
-                BasicBlock* parent = inst->getParent();
-                ICmpInst* icmp = dyn_cast<ICmpInst>(inst->getOperand(0));
-                BasicBlock* else_succ = dyn_cast<BasicBlock>(inst->getOperand(1));
-                BasicBlock* if_succ = dyn_cast<BasicBlock>(inst->getOperand(2));
+            Value* firstVal = icmp->getOperand(0);
+            Value* secondVal = icmp->getOperand(1);
+
+            VariableRange first;
+            VariableRange second;
+
+            // Determine what the first and second range we are calculating for.
+            if (isa<ConstantInt>(firstVal)) {
+                ConstantInt* constant = dyn_cast<ConstantInt>(firstVal);
+                int val = clampConstant(constant->getValue());
+                first.min_value = val;
+                first.max_value = val;
+            }
+            else {
+                first = if_ranges.get(firstVal);
+            }
+
+            if (isa<ConstantInt>(secondVal)) {
+                ConstantInt* constant = dyn_cast<ConstantInt>(secondVal);
+                int val = clampConstant(constant->getValue());
+                second.min_value = val;
+                second.max_value = val;
+            }
+            else {
+                second = if_ranges.get(secondVal);
+            }
+
+            VariableRange if_lhs, if_rhs, else_lhs, else_rhs;
+            refineICmp(icmp, first, second, if_lhs, if_rhs, else_lhs, else_rhs,
+                       if_reachable, else_reachable);
+
+            // Only loaded values are refined, in the local they were loaded from. Computed operands
+            // like i + 1 only decide reachability.
+            if (LoadInst* load = dyn_cast<LoadInst>(firstVal)) {
+                if_ranges.set(load->getPointerOperand(), if_lhs);
+                else_ranges.set(load->getPointerOperand(), else_lhs);
+            }
+
+            if (LoadInst* load = dyn_cast<LoadInst>(secondVal)) {
+                if_ranges.set(load->getPointerOperand(), if_rhs);
+                else_ranges.set(load->getPointerOperand(), else_rhs);
+            }
+        }
+
+        /*
+         * Description:
+         * Records ranges as the state on the edge from parent to succ. If the edge state changed,
+         * succ is queued to be visited again. Returns true if update was made.
+         */
+        bool updateSuccessorRanges(BasicBlock* parent, BasicBlock* succ, const Ranges& ranges) {
+            unordered_map<BasicBlock*, Ranges>& succ_ranges = state->bb_to_succ_ranges[parent];
+            auto previous = succ_ranges.find(succ);
+            if (previous != succ_ranges.end() && equal_ranges(ranges, previous->second)) {
+                return false;
+            }
+
+            succ_ranges[succ] = ranges;
+            pushWorklist(succ);
+            return true;
+        }
+
+        /*
+         * Description:
+         * From the branch instruction, determine what the resulting range is for all successors of the basic block.
+         * Returns true if update was made.
+         */
+        bool handleBranchInstruction(Instruction* inst, Ranges& ranges) {
+            BranchInst* branch = dyn_cast<BranchInst>(inst);
+            BasicBlock* parent = inst->getParent();
+
+            // If it is conditional on a compare, determine how the icmp effects the cases. Any other
+            // condition, like a phi of compares, may go both ways.
+            if (branch->isConditional() && isa<ICmpInst>(branch->getCondition())) {
+                ICmpInst* icmp = dyn_cast<ICmpInst>(inst->getOperand(0));
+                BasicBlock* else_succ = dyn_cast<BasicBlock>(inst->getOperand(1));
+                BasicBlock* if_succ = dyn_cast<BasicBlock>(inst->getOperand(2));
 
                 Ranges if_ranges = ranges;
                 Ranges else_ranges = ranges;
@@ -387,103 +984,151 @@ namespace {
                 handleICMP(icmp, if_ranges, else_ranges, if_reachable, else_reachable);
 
                 bool changed = false;
-                bool initialized = false;
 
-                // Possible to get to this successor
+                // Only update the successors it is possible to get to
                 if (if_reachable) {
-                    // Update if ranges
-                    if (bb_to_succ_ranges.count(parent)) {
-                        if (bb_to_succ_ranges[parent].count(if_succ)) {
-                            Ranges& previousRange = bb_to_succ_ranges[parent][if_succ];
-                            if (!equal_ranges(if_ranges, previousRange)) {
-                                bb_to_succ_ranges[parent][if_succ] = if_ranges;
-                                changed = true;
-                            }
-                        }
-                        else {
-                            bb_to_succ_ranges[parent][if_succ] = if_ranges;
-                            changed = true;
-                        }
-                    }
-                    else {
-                        bb_to_succ_ranges[parent][if_succ] = if_ranges;
-                        changed = true;
-                        initialized = true;
-                    }
+                    changed = updateSuccessorRanges(parent, if_succ, if_ranges) || changed;
                 }
 
                 if (else_reachable) {
-                     // Update else ranges
-                    if (!initialized) {
-                        if(bb_to_succ_ranges[parent].count(else_succ)) {
-                            Ranges& previousRange = bb_to_succ_ranges[parent][else_succ];
-                            if (!equal_ranges(else_ranges, previousRange)) {
-                                bb_to_succ_ranges[parent][else_succ] = else_ranges;
-                                changed = true;
-                            }
-                        }
-                        else {
-                            bb_to_succ_ranges[parent][else_succ] = else_ranges;
-                            changed = true;
-                        }
-                    }
-                    else {
-                        bb_to_succ_ranges[parent][else_succ] = else_ranges;
-                        changed = true;
-                    }
+                    changed = updateSuccessorRanges(parent, else_succ, else_ranges) || changed;
                 }
 
                 return changed;
             }
             else {
-                // If branch is unconditional, always use the same range as before
-                BasicBlock* parent = inst->getParent();
-                BasicBlock* succ = dyn_cast<BasicBlock>(inst->getOperand(0));
-
-                // Updated?
-                if (bb_to_succ_ranges.count(parent)) {
-                    assert(bb_to_succ_ranges[parent].count(succ));
-                    Ranges& previousRange = bb_to_succ_ranges[parent][succ];
-                    if (equal_ranges(ranges, previousRange)) {
-                        return false;
-                    }
-                    else {
-                        bb_to_succ_ranges[parent][succ] = ranges;
-                        return true;
-                    }
-                }
-                else {
-                    bb_to_succ_ranges[parent][succ] = ranges;
-                    return true;
-                }
-                
+                // Otherwise always use the same range as before
+                return handleOtherTerminator(inst, ranges);
+            }
+        }
+
+        /*
+         * Description:
+         * A terminator the ranges do not decide, like a switch, may go to all of its successors with
+         * the ranges as they are. Returns true if update was made.
+         */
+        bool handleOtherTerminator(Instruction* inst, Ranges& ranges) {
+            bool changed = false;
+            for (unsigned i = 0; i < inst->getNumSuccessors(); ++i) {
+                changed = updateSuccessorRanges(inst->getParent(), inst->getSuccessor(i), ranges) || changed;
             }
+            return changed;
         }
 
         // Get element pointer instructions
         void handleGEPOperations(Instruction* inst, Ranges& ranges) {
             // Nothing is assumed about values in arrays
-            ranges[inst] = VariableRange();
+            ranges.set(inst, VariableRange());
         }
 
         // Call instructions
         void handleCallOperations(Instruction* inst, Ranges& ranges) {
-            // Nothing is assumed about calls
-            ranges[inst] = VariableRange();
+            // Nothing is assumed about calls, unless the callee has a summary
+            CallInst* call = dyn_cast<CallInst>(inst);
+            if (!hasSummary(call)) {
+                VariableRange range;
+                getLibraryCallRange(call, range);
+                ranges.set(inst, range);
+                return;
+            }
+
+            vector<VariableRange> arguments;
+            for (unsigned i = 0; i < call->arg_size(); ++i) {
+                ConstantInt* constant = dyn_cast<ConstantInt>(call->getArgOperand(i));
+                if (constant) {
+                    int val = clampConstant(constant->getValue());
+                    arguments.push_back({val, val});
+                }
+                else {
+                    arguments.push_back(ranges.get(call->getArgOperand(i)));
+                }
+            }
+            ranges.set(inst, getCallRange(call, arguments));
+        }
+
+        /*
+         * Description:
+         * Joins the incoming ranges of a phi, each as its predecessor left it on the edge. Code that
+         * was partly promoted to registers has phis in memory mode too. They are joined when their
+         * block is entered, so a changed incoming value changes the state of the block.
+         */
+        void handlePhiOperations(PHINode* phi, Ranges& ranges) {
+            BasicBlock* parent = phi->getParent();
+            VariableRange range;
+            bool known = false;
+
+            for (unsigned i = 0; i < phi->getNumIncomingValues(); ++i) {
+                const Ranges* edge = getEdgeRanges(phi->getIncomingBlock(i), parent);
+                if (!edge) {
+                    continue;
+                }
+
+                VariableRange incoming;
+                ConstantInt* constant = dyn_cast<ConstantInt>(phi->getIncomingValue(i));
+                if (constant) {
+                    int val = clampConstant(constant->getValue());
+                    incoming = {val, val};
+                }
+                else {
+                    incoming = edge->get(phi->getIncomingValue(i));
+                }
+
+                range = known ? unionRange(range, incoming) : incoming;
+                known = true;
+            }
+            ranges.set(phi, range);
         }
 
-        // Cast instructions simply get the same range as the value we are casting from.
+        // Cast instructions get the range of the value we are casting from, as far as it fits. An
+        // operand without a range could be anything.
         void handleCastOperations(Instruction* inst, Ranges& ranges) {
-            assert(ranges.count(inst->getOperand(0)));
-            ranges[inst] = ranges[inst->getOperand(0)];
+            ranges.set(inst, castRange(inst, ranges.get(inst->getOperand(0))));
+        }
+
+        /*
+         * Description:
+         * The range of the result of the cast inst on a value of range. A zext turns negative values
+         * into large unsigned ones and a trunc cuts off what does not fit. A sext keeps what the
+         * narrow value can hold, any other cast keeps the range.
+         */
+        VariableRange castRange(Instruction* inst, const VariableRange& range) {
+            unsigned from_bits = inst->getOperand(0)->getType()->getScalarSizeInBits();
+            switch (inst->getOpcode()) {
+                case Instruction::ZExt :
+                    return zextRange(range, from_bits);
+                case Instruction::Trunc :
+                    return truncRange(range, from_bits, inst->getType()->getScalarSizeInBits());
+                case Instruction::SExt :
+                    return fitRange(range, from_bits);
+                default:
+                    return range;
+            }
+        }
+
+        /*
+         * Description:
+         * The bits of the integers val holds, of each element for vectors.
+         */
+        unsigned getBits(Value* val) {
+            return val->getType()->getScalarSizeInBits();
         }
 
         /*
          * Description:
          * Main function that determines how variables are updated depending on the instruction.
-         * If a range was updated, this returns true.
          */
-        bool handleInst(Instruction* inst, Ranges& ranges) {
+        void handleInst(Instruction* inst, Ranges& ranges) {
+            // Array accesses are checked and terminators decided later on, remember what holds right
+            // before them. The snapshot shares its chunks with ranges until either one is written to.
+            if (isa<GetElementPtrInst>(inst) || inst->isTerminator()) {
+                state->before_ranges[inst] = ranges;
+            }
+
+            if (state->demand_driven && !isDemanded(inst)) {
+                return;
+            }
+            ++state->instructions_transferred;
+
             // Update depending on the type of the instruction.
             switch (inst->getOpcode()) {
                 case Instruction::Alloca :
@@ -507,9 +1152,31 @@ namespace {
                 case Instruction::Mul :
                     handleBinaryOperations(inst, ranges, '*');
                     break;
+                case Instruction::SRem :
+                    handleBinaryOperations(inst, ranges, '%');
+                    break;
+                case Instruction::URem :
+                    handleBinaryOperations(inst, ranges, 'u');
+                    break;
+                case Instruction::UDiv :
+                    handleBinaryOperations(inst, ranges, 'd');
+                    break;
+                case Instruction::Shl :
+                    handleBinaryOperations(inst, ranges, '<');
+                    break;
+                case Instruction::AShr :
+                    handleBinaryOperations(inst, ranges, '>');
+                    break;
+                case Instruction::And :
+                    handleBinaryOperations(inst, ranges, '&');
+                    break;
+                case Instruction::Or :
+                    handleBinaryOperations(inst, ranges, '|');
+                    break;
                 case Instruction::Br :
-                    // Handles branches differently, should just return as it updates
-                    return handleBranchInstruction(inst, ranges);
+                    // Handles branches differently, it updates the outgoing edges
+                    handleBranchInstruction(inst, ranges);
+                    break;
                 case Instruction::GetElementPtr :
                     handleGEPOperations(inst, ranges);
                     break;
@@ -532,73 +1199,232 @@ namespace {
                     // Casting instructions, results should be same as input
                     handleCastOperations(inst, ranges);
                     break;
-                case Instruction::ICmp : // Ignore this instr, will be handled in branch
+                case Instruction::ICmp :
+                    // The branch refines the operands, the flag itself is true (-1) or false
+                    ranges.set(inst, {-1, 0});
+                    break;
+                case Instruction::PHI : // Joined when the block is entered, see visitBlock
                 case Instruction::Ret : // Ignore this instruction, nothing is assumed about post-condition
                     break;
                 default:
-                    errs() << *inst << "\n";
+                    if (inst->isTerminator()) {
+                        // What an invoke returns could be anything
+                        if (!inst->getType()->isVoidTy()) {
+                            ranges.set(inst, VariableRange());
+                        }
+                        handleOtherTerminator(inst, ranges);
+                        break;
+                    }
+                    LLVM_DEBUG(dbgs() << "BoundsCheck: nothing known about " << *inst << "\n");
                     break;
             }
+        }
 
-            // Check if range has been updated and update accordingly, widen if necessary
-            if (inst_to_ranges.count(inst)) {
-                if (equal_ranges(ranges, inst_to_ranges[inst])) {
-                    return false;
-                }
-                else {
-                    widen(ranges, inst_to_ranges[inst]);
-                    inst_to_ranges[inst] = ranges;
-                    return true;
+        /* 
+         * Description:
+         * If range is trending towards INT_MAX or INT_MIN, expand the range to the next threshold
+         * past it, or to INT_MAX or INT_MIN past the last one.
+         */
+        bool widen(Ranges& current, const Ranges& original) {
+            bool widened = current.widen(original, state->thresholds);
+            state->widenings += widened;
+            return widened;
+        }
+
+        /*
+         * Description:
+         * The bounds widening stops at before giving up on a range: the constants that are compared
+         * against, one off in both directions, and the first and last index of every array.
+         */
+        void collectThresholds(Function& F) {
+            vector<int>& thresholds = state->thresholds;
+            thresholds.push_back(0);
+
+            for (BasicBlock& BB : F) {
+                for (Instruction& I : BB) {
+                    if (isa<ICmpInst>(&I)) {
+                        for (Value* operand : I.operands()) {
+                            ConstantInt* constant = dyn_cast<ConstantInt>(operand);
+                            if (!constant || constant->getValue().getMinSignedBits() > INT_SIZE) {
+                                continue;
+                            }
+
+                            int value = clampConstant(constant->getValue());
+                            thresholds.push_back(value);
+                            if (value != INT_MIN) {
+                                thresholds.push_back(value - 1);
+                            }
+                            if (value != INT_MAX) {
+                                thresholds.push_back(value + 1);
+                            }
+                        }
+                    }
+
+                    vector<ArrayIndex> indices;
+                    if (isa<GetElementPtrInst>(&I)) {
+                        getArrayIndices(dyn_cast<GetElementPtrInst>(&I), indices);
+                    }
+                    for (const ArrayIndex& index : indices) {
+                        thresholds.push_back(index.array_size);
+                        thresholds.push_back(index.array_size - 1);
+                    }
                 }
             }
-            else {
-                inst_to_ranges[inst] = ranges;
+
+            std::sort(thresholds.begin(), thresholds.end());
+            thresholds.erase(std::unique(thresholds.begin(), thresholds.end()), thresholds.end());
+        }
+
+        /*
+         * Description:
+         * The places where the solvers widen: the loop headers, and for cycles with several entries,
+         * which LoopInfo does not treat as loops, the targets of retreating edges in reverse post-order.
+         */
+        bool isLoopHeader(BasicBlock* BB) {
+            if (state->loop_info->isLoopHeader(BB)) {
                 return true;
             }
+
+            unsigned index = state->rpo_index[BB];
+            for (BasicBlock* pred : predecessors(BB)) {
+                auto pred_index = state->rpo_index.find(pred);
+                if (pred_index != state->rpo_index.end() && pred_index->second >= index) {
+                    return true;
+                }
+            }
+            return false;
         }
 
-        /* 
+        /*
          * Description:
-         * If range is trending towards INT_MAX or INT_MIN, simply expand the range to INT_MAX or INT_MIN
+         * Merges the states on the incoming edges of current and runs its instructions, which update
+         * the states on its outgoing edges. Loop headers are widened against their previous state,
+         * unless the solver is narrowing. Returns false if the block was not reached yet or its state
+         * did not change.
          */
-        bool widen(Ranges& current, Ranges& original) {
-            bool widened = false;
+        bool visitBlock(BasicBlock* current) {
+            // Create a new range
+            Ranges unioned(state->numbering);
 
-            for (auto& val_to_var_range : current) {
-                Value* val = val_to_var_range.first;
-                VariableRange& range = val_to_var_range.second;
+            bool valid = !current->hasNPredecessorsOrMore(1);
 
-                if (original.count(val)) {
-                    VariableRange& otherRange = original[val];
+            // If this basic block has a predecessor, intersect the ranges of them
+            if (!valid) {
+                // Get the first predecessor and set it to unioned
+                bool initialized = false;
 
-                    if (range.max_value > otherRange.max_value) {
-                        range.max_value = INT_MAX;
-                        widened = true;
+                // Go through all predecessors to merge
+                for (BasicBlock* pred : predecessors(current)) {
+                    if (state->bb_to_succ_ranges.count(pred)) {
+                        if (state->bb_to_succ_ranges[pred].count(current)) {
+                            if (!initialized) {
+                                unioned = state->bb_to_succ_ranges[pred][current];
+                                initialized = true;
+                                valid = true;
+                            }
+                            else {
+                                intersectRanges(unioned, state->bb_to_succ_ranges[pred][current]);
+                            }
+                        }
                     }
+                }
+            }
 
-                    if (range.min_value < otherRange.min_value) {
-                        range.min_value = INT_MIN;
-                        widened = true;
-                    }
+            // No predecessors reached this block and this is not the entry block.
+            if (!valid) {
+                return false;
+            }
+
+            // The entry starts out with what the callers pass
+            if (!current->hasNPredecessorsOrMore(1)) {
+                for (Argument& arg : current->getParent()->args()) {
+                    unioned.set(&arg, getArgumentRange(&arg));
                 }
             }
 
-            return widened;
+            // Phis are part of the state on entry, so they are widened with it
+            for (PHINode& phi : current->phis()) {
+                handlePhiOperations(&phi, unioned);
+            }
+
+            // Update the before range appropriately, nothing to do if it did not change.
+            if (state->basic_block_before_ranges.count(current)) {
+                const Ranges& before = state->basic_block_before_ranges[current];
+                if (!state->narrowing && isLoopHeader(current)) {
+                    intersectRanges(unioned, before);
+                    widen(unioned, before);
+                }
+
+                if (equal_ranges(before, unioned)) {
+                    return false;
+                }
+            }
+            state->basic_block_before_ranges[current] = unioned;
+            ++state->blocks_visited;
+
+            // Update the variables in the function, changed edges queue their successors
+            for (Instruction& I : *current) {
+                handleInst(&I, unioned);
+            }
+            return true;
+        }
+
+        /*
+         * Description:
+         * Drops everything still queued, once a solver is done.
+         */
+        void clearWorklists() {
+            state->worklist = priority_queue<unsigned, vector<unsigned>, greater<unsigned> >();
+            state->in_worklist.assign(state->rpo_blocks.size(), false);
+            state->ssa_worklist.clear();
         }
 
         /*
          * Description:
-         * Get array sizes from all arrays in the function F
+         * A few more rounds over all reached blocks in reverse post-order without widening. Starting
+         * from the fixed point every round stays sound, and the compares inside loops pull the bounds
+         * that were widened back in. Stops early once a round changes nothing.
+         */
+        void narrowMemory() {
+            state->narrowing = true;
+            for (unsigned round = 0; round < NarrowingRounds; ++round) {
+                bool changed = false;
+                for (BasicBlock* BB : state->rpo_blocks) {
+                    if (state->basic_block_before_ranges.count(BB)) {
+                        ++state->solver_iterations;
+                        changed = visitBlock(BB) || changed;
+                    }
+                }
+
+                if (!changed) {
+                    break;
+                }
+            }
+            clearWorklists();
+        }
+
+        // An index of an array access: the operand of gep that selects one of array_size elements
+        struct ArrayIndex {
+            Instruction* gep;
+            unsigned operand;
+            int array_size;
+        };
+
+        /*
+         * Description:
+         * Get the indices into arrays of every array access in the function F, with the sizes their
+         * types give. Accesses into heap arrays get their size once the ranges are known.
          */
         void getArrayInformation(Function& F) {
-            auto DL = F.getParent()->getDataLayout();
             for (BasicBlock& BB : F) {
                 for (Instruction& I : BB) {
-                    if (isa<AllocaInst>(&I)) {
-                        AllocaInst* alloca = dyn_cast<AllocaInst>(&I);
-                        if (alloca->getAllocatedType()->isArrayTy()) {
-                            array_sizes[alloca] = alloca->getAllocationSizeInBits(DL).getValue() / INT_SIZE;
+                    if (isa<GetElementPtrInst>(&I)) {
+                        vector<ArrayIndex> indices;
+                        getArrayIndices(dyn_cast<GetElementPtrInst>(&I), indices);
+                        if (!indices.empty()) {
+                            state->array_indices[&I] = indices;
                         }
+                        collectHeapAccess(dyn_cast<GetElementPtrInst>(&I));
                     }
                 }
             }
@@ -606,217 +1432,3218 @@ namespace {
 
         /*
          * Description:
-         * Get the ranges that precedes the instruction listed.
+         * The number of elements of array, false if its type does not tell how long it really is:
+         * arrays without elements, and arrays of one element that end a struct, which C code
+         * allocates longer (flexible array members).
          */
-        Ranges& getBeforeRanges(Instruction* inst) {
-            if (&(*(inst->getParent()->begin())) == inst) {
-                return basic_block_before_ranges[inst->getParent()];
+        bool getDimensionSize(ArrayType* array, bool ends_struct, int& array_size) {
+            uint64_t elements = array->getNumElements();
+            if (elements == 0 || (elements == 1 && ends_struct)) {
+                return false;
             }
-            else {
-                Instruction* prev = nullptr;
-                for (Instruction& I : *(inst->getParent())) {
-                    if (inst == &I) {
-                        break;
+            array_size = static_cast<int>(min<uint64_t>(elements, INT_MAX));
+            return true;
+        }
+
+        /*
+         * Description:
+         * Does pointer point to the last field of a struct, selected by the last index of a gep.
+         */
+        bool isLastField(Value* pointer) {
+            GEPOperator* gep = dyn_cast<GEPOperator>(pointer->stripPointerCasts());
+            if (!gep || gep->getNumIndices() < 2) {
+                return false;
+            }
+
+            SmallVector<Value*, 4> leading(gep->idx_begin(), gep->idx_end() - 1);
+            StructType* parent = dyn_cast_or_null<StructType>(
+                GetElementPtrInst::getIndexedType(gep->getSourceElementType(), leading));
+            ConstantInt* field = dyn_cast<ConstantInt>(*(gep->idx_end() - 1));
+            return parent && field && field->getZExtValue() + 1 == parent->getNumElements();
+        }
+
+        /*
+         * Description:
+         * The indices of gep that select from an array type, every dimension of a multi-dimensional
+         * array and arrays within structs alike. The first index moves over whole objects, it is only
+         * known to be bounded for heap arrays. Indices into structs are constants.
+         */
+        void getArrayIndices(GetElementPtrInst* gep, vector<ArrayIndex>& indices) {
+            Type* indexed = gep->getSourceElementType();
+            bool ends_struct = isLastField(gep->getPointerOperand());
+            for (unsigned operand = 2; operand < gep->getNumOperands(); ++operand) {
+                if (ArrayType* array = dyn_cast<ArrayType>(indexed)) {
+                    int array_size;
+                    if (getDimensionSize(array, ends_struct, array_size)) {
+                        indices.push_back({gep, operand, array_size});
                     }
-                    prev = &I;
+                    indexed = array->getElementType();
+                    ends_struct = false;
+                    continue;
                 }
 
-                return inst_to_ranges[prev];
+                // Vectors are not checked, elements of vectors of pointers are left alone
+                StructType* record = dyn_cast<StructType>(indexed);
+                ConstantInt* field = dyn_cast<ConstantInt>(gep->getOperand(operand));
+                if (!record || !field) {
+                    return;
+                }
+                ends_struct = field->getZExtValue() + 1 == record->getNumElements();
+                indexed = record->getElementType(field->getZExtValue());
             }
         }
 
         /*
          * Description:
-         * On error, prints the debug information a getElementPtr instruction may have incurred.
+         * Get the ranges that precedes the instruction listed, an array access or a terminator.
          */
-        void printDebugInformation(Instruction* inst) {
-            DILocation* loc = inst->getDebugLoc();
-            if (!loc) {
-                errs() << "WARNING: Array out of bounds access at ";
-                errs() << *inst << "\n";
-                errs() << "Please compile with -g to see line numbers.\n";
+        const Ranges& getBeforeRanges(Instruction* inst) {
+            return state->before_ranges[inst];
+        }
+
+        /*
+         * Description:
+         * The range of val right before inst, an array access or a terminator. Returns false if inst
+         * is not reachable.
+         */
+        bool getRangeBefore(Instruction* inst, Value* val, VariableRange& range) {
+            if (state->gave_up) {
+                ConstantInt* constant = dyn_cast<ConstantInt>(val);
+                int value = constant ? clampConstant(constant->getValue()) : 0;
+                range = constant ? VariableRange{value, value} : VariableRange();
+                return true;
+            }
+
+            if (state->ssa_mode) {
+                return isExecutable(inst->getParent()) && getRangeAt(val, inst->getParent(), range);
+            }
+
+            // Only the accesses and terminators the solver reached have a snapshot
+            if (!state->before_ranges.count(inst)) {
+                return false;
+            }
+
+            if (isa<ConstantInt>(val)) {
+                ConstantInt* constant = dyn_cast<ConstantInt>(val);
+                range.min_value = clampConstant(constant->getValue());
+                range.max_value = range.min_value;
             }
             else {
-                loc->getDirectory();
-                errs() << loc->getFilename() << ":" << loc->getLine() << ":"; 
-                errs() << loc->getColumn() << ": warning: Array out of bounds access.\n";
-            }   
+                range = getBeforeRanges(inst).get(val);
+            }
+            return true;
         }
 
         /*
          * Description:
          * Checks all of the array bounds in the function F. Determines if they will be indexed out of bounds.
+         * Accesses that are not proven to stay in bounds are remembered for reportAccesses, and
+         * so they can be guarded.
          */
         void checkArrayBounds(Function& F) {
             // Iterate through all instructions
             for (BasicBlock& BB : F) {
                 for (Instruction& I : BB) {
-                    // An array access
-                    if (isa<GetElementPtrInst>(&I)) {
-                        if (!inst_to_ranges.count(&I)) {
-                            // We determined this block was not reachable
-                            continue;
-                        }
+                    // An array access, only indices into arrays we know the size of can be checked
+                    if (!isa<GetElementPtrInst>(&I)) {
+                        continue;
+                    }
 
-                        Ranges& ranges = getBeforeRanges(&I);
-                        AllocaInst* array = dyn_cast<AllocaInst>(I.getOperand(0));
-                        assert(array_sizes.count(array));
-                        int array_size = array_sizes[array];
+                    vector<ArrayIndex> indices;
+                    int heap_size;
+                    if (getHeapArraySize(dyn_cast<GetElementPtrInst>(&I), heap_size)) {
+                        indices.push_back({&I, 1, heap_size});
+                    }
+                    auto typed = state->array_indices.find(&I);
+                    if (typed != state->array_indices.end()) {
+                        indices.insert(indices.end(), typed->second.begin(), typed->second.end());
+                    }
 
+                    // Every dimension is checked on its own
+                    for (const ArrayIndex& index : indices) {
                         // Get the range of the corresponding index
-                        Value* index = I.getOperand(2);
                         VariableRange range;
-                        if (isa<ConstantInt>(index)) {
-                            ConstantInt* constant = dyn_cast<ConstantInt>(index);
-                            range.min_value = static_cast<int>(constant->getSExtValue());
-                            range.max_value = range.min_value;
+                        if (!getRangeBefore(&I, I.getOperand(index.operand), range)) {
+                            // We determined this block was not reachable
+                            break;
+                        }
+
+                        // If range is out of range of array size, it is reported
+                        bool out_of_bounds = outOfRange(range, index.array_size);
+                        if (out_of_bounds) {
+                            ++state->num_out_of_bounds;
+                        }
+                        else if (inRange(range, index.array_size)) {
+                            ++state->num_proven_safe;
+                            continue;
+                        }
+                        else if (RelationalChecks && !state->gave_up && proveByDifferences(index, range)) {
+                            ++state->num_proven_safe;
+                            ++NumAccessesProvenRelational;
+                            continue;
                         }
                         else {
-                            range = ranges[index];
+                            ++state->num_unproven;
                         }
+                        state->findings.push_back({&I, index.array_size, range, out_of_bounds});
 
-                        // If range is out of range of array size, print debug
-                        if (outOfRange(range, array_size)) {
-                            printDebugInformation(&I);
+                        // Failure paths end in a trap anyway, guarding them gains nothing
+                        if (!isCheckFailure(&BB)) {
+                            state->unproven_accesses.push_back(index);
                         }
                     }
                 }
             }
+
+            NumAccessesChecked += state->num_proven_safe + state->num_unproven + state->num_out_of_bounds;
+            NumAccessesProvenSafe += state->num_proven_safe;
+            NumAccessesOutOfBounds += state->num_out_of_bounds;
+            NumAccessesUnknown += state->num_unproven;
         }
 
+        // ================== BEGIN HEAP ARRAYS ================== //
+
         /*
          * Description:
-         * Main code of the algorithm. This is what is called on each function.
+         * The range a call to a function of the C library returns, if it is one whose results are
+         * bounded. Returns false for any other call.
          */
-        virtual bool runOnFunction(Function &F) {
-            // Reset member variables. Necessary since this carries over between functions
-            bb_succs.clear();
-            inst_to_ranges.clear();
-            basic_block_before_ranges.clear();
-            bb_to_succ_ranges.clear();
-            array_sizes.clear();
-
-            // Find successsors for each block
-            createSuccessorMap(F);
-
-            // Continually iterate through this until convergence.
-            bool changed = true;
-            int count = 0;
-            while (changed) {
-                changed = false;
-
-                // Iterate in bfs order
-                BasicBlock& init = F.getEntryBlock();
-                queue<BasicBlock*> bfs;
-                unordered_set<BasicBlock*> visited;
-                bfs.push(&init);
-                visited.insert(&init);
-
-                while (bfs.size()) {
-                    // Get the next bb
-                    BasicBlock* current = bfs.front();
-                    bfs.pop();
-
-                    // Push in the successors to the bb
-                    for (BasicBlock* succ : bb_succs[current]) {
-                        if (!visited.count(succ)) {
-                            bfs.push(succ);
-                            visited.insert(succ);
+        bool getLibraryCallRange(CallInst* call, VariableRange& range) {
+            Function* callee = call->getCalledFunction();
+            if (!callee || !callee->isDeclaration() || !call->getType()->isIntegerTy()) {
+                return false;
+            }
+
+            // RAND_MAX is at most INT_MAX
+            StringRef name = callee->getName();
+            if (name == "rand" || name == "random" || name == "lrand48") {
+                range = {0, INT_MAX};
+                return true;
+            }
+            return false;
+        }
+
+        /*
+         * Description:
+         * The call that allocated the memory pointer points to, if it is malloc, calloc or operator
+         * new. A pointer loaded from a local that is stored to once and never escapes is the pointer
+         * stored there. Returns nullptr if the allocation is not known.
+         */
+        CallInst* getAllocationCall(Value* pointer) {
+            pointer = pointer->stripPointerCasts();
+            LoadInst* load = dyn_cast<LoadInst>(pointer);
+            AllocaInst* slot = load ? dyn_cast<AllocaInst>(load->getPointerOperand()) : nullptr;
+            if (slot) {
+                StoreInst* only_store = nullptr;
+                for (User* user : slot->users()) {
+                    StoreInst* store = dyn_cast<StoreInst>(user);
+                    if (store && store->getPointerOperand() == slot && !only_store) {
+                        only_store = store;
+                    }
+                    else if (!isa<LoadInst>(user)) {
+                        return nullptr;
+                    }
+                }
+                if (!only_store) {
+                    return nullptr;
+                }
+                pointer = only_store->getValueOperand()->stripPointerCasts();
+            }
+
+            CallInst* call = dyn_cast<CallInst>(pointer);
+            Function* callee = call ? call->getCalledFunction() : nullptr;
+            if (!callee || !callee->isDeclaration()) {
+                return nullptr;
+            }
+
+            // operator new and new[], for 64 and 32 bit size_t
+            StringRef name = callee->getName();
+            if (name == "malloc" || name == "calloc" || name == "_Znwm" || name == "_Znam" ||
+                name == "_Znwj" || name == "_Znaj") {
+                return call;
+            }
+            return nullptr;
+        }
+
+        /*
+         * Description:
+         * The fewest bytes the allocation call may return, false if that is not known.
+         */
+        bool getAllocatedBytes(CallInst* call, long long& bytes) {
+            bytes = 1;
+            unsigned num_sizes = call->getCalledFunction()->getName() == "calloc" ? 2 : 1;
+            if (call->arg_size() < num_sizes) {
+                return false;
+            }
+
+            for (unsigned i = 0; i < num_sizes; ++i) {
+                VariableRange size;
+                if (!getRange(call->getArgOperand(i), call, size) || size.min_value <= 0) {
+                    return false;
+                }
+                bytes *= size.min_value;
+            }
+            return true;
+        }
+
+        /*
+         * Description:
+         * The number of elements the first index of gep selects from, if gep moves through the
+         * memory of a known allocation. Returns false otherwise.
+         */
+        bool getHeapArraySize(GetElementPtrInst* gep, int& array_size) {
+            auto heap = state->heap_accesses.find(gep);
+            long long bytes;
+            if (heap == state->heap_accesses.end() || !getAllocatedBytes(heap->second.allocation, bytes)) {
+                return false;
+            }
+            array_size = static_cast<int>(min<long long>(bytes / heap->second.element_size, INT_MAX));
+            return true;
+        }
+
+        // An access into a heap array: the call that allocated it and the bytes of one element
+        struct HeapAccess {
+            CallInst* allocation;
+            uint64_t element_size;
+        };
+
+        /*
+         * Description:
+         * Remembers the allocation and element size of gep if it moves through a heap array. The
+         * data layout caches the layout of struct elements, so this runs before solving, when
+         * nothing else uses the context.
+         */
+        void collectHeapAccess(GetElementPtrInst* gep) {
+            CallInst* allocation = getAllocationCall(gep->getPointerOperand());
+            if (!allocation) {
+                return;
+            }
+
+            const DataLayout& DL = gep->getModule()->getDataLayout();
+            uint64_t element_size = DL.getTypeAllocSize(gep->getSourceElementType());
+            if (element_size != 0) {
+                state->heap_accesses[gep] = {allocation, element_size};
+            }
+        }
+
+        // ================== END HEAP ARRAYS ================== //
+
+        // ================== BEGIN DIFFERENCE CONSTRAINTS ================== //
+
+        /*
+         * Description:
+         * Splits val into atom + offset, looking through sext and the addition of constants. A
+         * constant has no atom. In memory mode a load from a local stands for the local, load is
+         * then the load. Like the ranges, this assumes that nothing overflows.
+         */
+        void getOffsetTerm(Value* val, Value*& atom, long long& offset, LoadInst*& load) {
+            offset = 0;
+            load = nullptr;
+            while (true) {
+                ConstantInt* constant = dyn_cast<ConstantInt>(val);
+                if (constant && constant->getValue().getMinSignedBits() <= INT_SIZE) {
+                    atom = nullptr;
+                    offset += constant->getSExtValue();
+                    return;
+                }
+
+                Instruction* inst = dyn_cast<Instruction>(val);
+                if (isa<SExtInst>(val)) {
+                    val = inst->getOperand(0);
+                    continue;
+                }
+
+                ConstantInt* step = inst && isa<BinaryOperator>(inst) ? dyn_cast<ConstantInt>(inst->getOperand(1)) : nullptr;
+                if (step && step->getValue().getMinSignedBits() <= INT_SIZE &&
+                    (inst->getOpcode() == Instruction::Add || inst->getOpcode() == Instruction::Sub)) {
+                    offset += inst->getOpcode() == Instruction::Add ? step->getSExtValue() : -step->getSExtValue();
+                    val = inst->getOperand(0);
+                    continue;
+                }
+                break;
+            }
+
+            load = state->ssa_mode ? nullptr : dyn_cast<LoadInst>(val);
+            AllocaInst* slot = load ? dyn_cast<AllocaInst>(load->getPointerOperand()) : nullptr;
+            if (slot && isRelatableSlot(slot)) {
+                atom = slot;
+                return;
+            }
+            atom = val;
+            load = nullptr;
+        }
+
+        /*
+         * Description:
+         * Can the differences of slot to other values be followed through the function: a scalar
+         * local only loaded and stored to, so only its stores change it.
+         */
+        bool isRelatableSlot(AllocaInst* slot) {
+            if (slot->getAllocatedType()->isArrayTy()) {
+                return false;
+            }
+            for (User* user : slot->users()) {
+                StoreInst* store = dyn_cast<StoreInst>(user);
+                if (!isa<LoadInst>(user) && !(store && store->getPointerOperand() == slot)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /*
+         * Description:
+         * Is there a store to slot in BB between from and to, nullptr standing for the start and the
+         * end of BB.
+         */
+        bool storesBetween(AllocaInst* slot, BasicBlock* BB, Instruction* from, Instruction* to) {
+            BasicBlock::iterator it = from ? std::next(from->getIterator()) : BB->begin();
+            BasicBlock::iterator end = to ? to->getIterator() : BB->end();
+            for (; it != end; ++it) {
+                StoreInst* store = dyn_cast<StoreInst>(&*it);
+                if (store && store->getPointerOperand() == slot) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /*
+         * Description:
+         * Does slot hold the same value at access as when the edge from source to target was taken.
+         * Every path back from access ends at that edge, since it dominates access, so only the
+         * blocks on these paths can store to slot in between.
+         */
+        bool isUnchangedSince(AllocaInst* slot, BasicBlock* source, BasicBlock* target, Instruction* access) {
+            BasicBlock* BB = access->getParent();
+            if (storesBetween(slot, BB, nullptr, access)) {
+                return false;
+            }
+
+            SmallPtrSet<BasicBlock*, 16> visited;
+            vector<BasicBlock*> worklist = {BB};
+            while (!worklist.empty()) {
+                BasicBlock* current = worklist.back();
+                worklist.pop_back();
+                for (BasicBlock* pred : predecessors(current)) {
+                    if ((current == target && pred == source) || !visited.insert(pred).second) {
+                        continue;
+                    }
+                    if (storesBetween(slot, pred, nullptr, nullptr)) {
+                        return false;
+                    }
+                    worklist.push_back(pred);
+                }
+            }
+            return true;
+        }
+
+        // x - y <= bound, x and y are values related at an access, nullptr for zero
+        struct Difference {
+            Value* x;
+            Value* y;
+            long long bound;
+        };
+
+        /*
+         * Description:
+         * The differences the compare of the branch from source to target puts on its operands when
+         * target is reached. Unsigned compares only give them where they agree with the signed one.
+         * In memory mode, a compared local may not change after its load, nor between the branch
+         * and access. Returns false if nothing can be used.
+         */
+        bool getEdgeDifferences(BasicBlock* source, BasicBlock* target, Instruction* access,
+                                vector<Difference>& differences) {
+            BranchInst* branch = dyn_cast<BranchInst>(source->getTerminator());
+            ICmpInst* icmp = branch && branch->isConditional() ? dyn_cast<ICmpInst>(branch->getCondition()) : nullptr;
+            if (!icmp || branch->getSuccessor(0) == branch->getSuccessor(1) ||
+                !icmp->getOperand(0)->getType()->isIntegerTy()) {
+                return false;
+            }
+
+            CmpInst::Predicate predicate = branch->getSuccessor(0) == target ? icmp->getPredicate() :
+                                           icmp->getInversePredicate();
+            if (ICmpInst::isUnsigned(predicate)) {
+                VariableRange first, second;
+                if (!getRangeBefore(branch, icmp->getOperand(0), first) ||
+                    !getRangeBefore(branch, icmp->getOperand(1), second)) {
+                    return false;
+                }
+                bool both = first.min_value >= 0 && second.min_value >= 0;
+                bool below = (predicate == CmpInst::Predicate::ICMP_ULT || predicate == CmpInst::Predicate::ICMP_ULE) &&
+                             second.min_value >= 0;
+                bool above = (predicate == CmpInst::Predicate::ICMP_UGT || predicate == CmpInst::Predicate::ICMP_UGE) &&
+                             first.min_value >= 0;
+                if (!both && !below && !above) {
+                    return false;
+                }
+                predicate = ICmpInst::getSignedPredicate(predicate);
+            }
+
+            Value* atoms[2];
+            long long offsets[2];
+            for (unsigned i = 0; i < 2; ++i) {
+                LoadInst* load;
+                getOffsetTerm(icmp->getOperand(i), atoms[i], offsets[i], load);
+                AllocaInst* slot = dyn_cast_or_null<AllocaInst>(atoms[i]);
+                if (load && (load->getParent() != source || storesBetween(slot, source, load, nullptr) ||
+                             !isUnchangedSince(slot, source, target, access))) {
+                    return false;
+                }
+            }
+            if (atoms[0] == atoms[1]) {
+                return false;
+            }
+
+            // a + ca < b + cb is a - b <= cb - ca - 1
+            long long difference = offsets[1] - offsets[0];
+            switch (predicate) {
+                case CmpInst::Predicate::ICMP_SLT :
+                    differences.push_back({atoms[0], atoms[1], difference - 1});
+                    break;
+                case CmpInst::Predicate::ICMP_SLE :
+                    differences.push_back({atoms[0], atoms[1], difference});
+                    break;
+                case CmpInst::Predicate::ICMP_SGT :
+                    differences.push_back({atoms[1], atoms[0], -difference - 1});
+                    break;
+                case CmpInst::Predicate::ICMP_SGE :
+                    differences.push_back({atoms[1], atoms[0], -difference});
+                    break;
+                case CmpInst::Predicate::ICMP_EQ :
+                    differences.push_back({atoms[0], atoms[1], difference});
+                    differences.push_back({atoms[1], atoms[0], -difference});
+                    break;
+                default:
+                    return false;
+            }
+            return true;
+        }
+
+        /*
+         * Description:
+         * Tries to prove the index of access in bounds from the differences between the values
+         * involved, where its range alone is not enough, as for a[i + 1] under i + 1 < n and n <= 30.
+         * The index, the compares of the branches that dominate the access and the ranges of their
+         * values at the access give constraints x - y <= c over at most MaxRelatedValues values.
+         * Their closure bounds the index.
+         */
+        bool proveByDifferences(const ArrayIndex& access, const VariableRange& range) {
+            Instruction* gep = access.gep;
+            BasicBlock* BB = gep->getParent();
+
+            // The index is plus - minus + offset
+            Value* plus;
+            Value* minus = nullptr;
+            long long offset;
+            LoadInst* load;
+            getOffsetTerm(gep->getOperand(access.operand), plus, offset, load);
+            vector<LoadInst*> index_loads = {load};
+            Instruction* difference = dyn_cast_or_null<Instruction>(plus);
+            if (difference && difference->getOpcode() == Instruction::Sub) {
+                long long plus_offset, minus_offset;
+                getOffsetTerm(difference->getOperand(0), plus, plus_offset, load);
+                index_loads.push_back(load);
+                getOffsetTerm(difference->getOperand(1), minus, minus_offset, load);
+                index_loads.push_back(load);
+                offset += plus_offset - minus_offset;
+            }
+
+            // A local holds the index value at the access if it is not stored to after its load
+            for (LoadInst* index_load : index_loads) {
+                if (index_load && (index_load->getParent() != BB ||
+                                   storesBetween(cast<AllocaInst>(index_load->getPointerOperand()), BB, index_load, gep))) {
+                    return false;
+                }
+            }
+
+            vector<Difference> differences;
+            DomTreeNode* node = state->dom_tree->getNode(BB);
+            for (; node && node->getIDom(); node = node->getIDom()) {
+                BasicBlock* source = node->getIDom()->getBlock();
+                for (BasicBlock* succ : successors(source)) {
+                    if (state->dom_tree->dominates(BasicBlockEdge(source, succ), BB)) {
+                        getEdgeDifferences(source, succ, gep, differences);
+                    }
+                }
+            }
+
+            // The values related, zero first, then the index ones, then those nearest to the access
+            vector<Value*> values = {nullptr};
+            auto getNode = [&](Value* val) -> int {
+                auto found = std::find(values.begin(), values.end(), val);
+                if (found != values.end()) {
+                    return found - values.begin();
+                }
+                if (values.size() >= MaxRelatedValues) {
+                    return -1;
+                }
+                values.push_back(val);
+                return values.size() - 1;
+            };
+            int p = getNode(plus);
+            int m = getNode(minus);
+            if (p < 0 || m < 0) {
+                return false;
+            }
+            for (const Difference& constraint : differences) {
+                getNode(constraint.x);
+                getNode(constraint.y);
+            }
+
+            const long long unbounded = LLONG_MAX / 4;
+            unsigned size = values.size();
+            vector<long long> bounds(size * size, unbounded);
+            for (unsigned i = 0; i < size; ++i) {
+                bounds[i * size + i] = 0;
+            }
+
+            // The ranges at the access are differences to zero
+            for (unsigned i = 1; i < size; ++i) {
+                VariableRange value_range;
+                if (isa<AllocaInst>(values[i])) {
+                    value_range = getBeforeRanges(gep).get(values[i]);
+                }
+                else if (!getRangeBefore(gep, values[i], value_range)) {
+                    return false;
+                }
+                if (value_range.max_value != INT_MAX) {
+                    bounds[i * size] = value_range.max_value;
+                }
+                if (value_range.min_value != INT_MIN) {
+                    bounds[i] = -static_cast<long long>(value_range.min_value);
+                }
+            }
+
+            for (const Difference& constraint : differences) {
+                int x = getNode(constraint.x);
+                int y = getNode(constraint.y);
+                if (x >= 0 && y >= 0) {
+                    bounds[x * size + y] = min(bounds[x * size + y], constraint.bound);
+                }
+            }
+
+            // Closure over the few values related, x - z <= (x - y) + (y - z)
+            for (unsigned k = 0; k < size; ++k) {
+                for (unsigned i = 0; i < size; ++i) {
+                    for (unsigned j = 0; j < size; ++j) {
+                        if (bounds[i * size + k] < unbounded && bounds[k * size + j] < unbounded) {
+                            bounds[i * size + j] = min(bounds[i * size + j], bounds[i * size + k] + bounds[k * size + j]);
+                        }
+                    }
+                }
+            }
+            for (unsigned i = 0; i < size; ++i) {
+                if (bounds[i * size + i] < 0) {
+                    // The constraints contradict, the access is not reached. The ranges decide that.
+                    return false;
+                }
+            }
+
+            // plus - minus + offset >= 0 and <= array_size - 1
+            bool lower = range.min_value >= 0 || bounds[m * size + p] <= offset;
+            bool upper = range.max_value < access.array_size || bounds[p * size + m] <= access.array_size - 1 - offset;
+            return lower && upper;
+        }
+
+        // ================== END DIFFERENCE CONSTRAINTS ================== //
+
+        // ================== BEGIN FUNCTION SUMMARIES ================== //
+
+        /*
+         * Description:
+         * Use the summaries of the interprocedural analysis for arguments and calls from now on.
+         * Without them, nothing is known about either.
+         */
+        void setSummaries(const SummaryMap* function_summaries) {
+            summaries = function_summaries;
+        }
+
+        /*
+         * Description:
+         * The range arg was analyzed with, [INT_MIN, INT_MAX] if its callers are not known.
+         */
+        VariableRange getArgumentRange(Argument* arg) {
+            if (!summaries || !summaries->count(arg->getParent())) {
+                return VariableRange();
+            }
+            return summaries->at(arg->getParent()).arguments[arg->getArgNo()];
+        }
+
+        /*
+         * Description:
+         * Does call return an integer whose range a summary may know.
+         */
+        bool hasSummary(CallInst* call) {
+            Function* callee = call->getCalledFunction();
+            return summaries && callee && !call->getType()->isVoidTy() && summaries->count(callee);
+        }
+
+        /*
+         * Description:
+         * The range call returns. The summary of the callee only holds for arguments within the
+         * ranges it was analyzed with, and within a recursive cycle the callee may not be solved yet.
+         */
+        VariableRange getCallRange(CallInst* call, const vector<VariableRange>& arguments) {
+            const FunctionSummary& summary = summaries->at(call->getCalledFunction());
+            if (!summary.solved || arguments.size() != summary.arguments.size()) {
+                return VariableRange();
+            }
+
+            for (unsigned i = 0; i < arguments.size(); ++i) {
+                if (!containsRange(summary.arguments[i], arguments[i])) {
+                    return VariableRange();
+                }
+            }
+
+            return summary.returned;
+        }
+
+        /*
+         * Description:
+         * The union of the ranges of every value F returns on a reached path, [INT_MIN, INT_MAX]
+         * if F returns no integer.
+         */
+        VariableRange getReturnedRange(Function& F) {
+            bool returns = false;
+            VariableRange returned;
+            for (BasicBlock& BB : F) {
+                ReturnInst* ret = dyn_cast<ReturnInst>(BB.getTerminator());
+                VariableRange range;
+                if (!ret || !ret->getReturnValue() || !getRangeBefore(ret, ret->getReturnValue(), range)) {
+                    continue;
+                }
+
+                returned = returns ? unionRange(returned, range) : range;
+                returns = true;
+            }
+            return returned;
+        }
+
+        /*
+         * Description:
+         * Joins the ranges of the arguments at every reached call of F into incoming, for the callees
+         * that have a summary.
+         */
+        void collectCallArguments(Function& F, unordered_map<Function*, vector<VariableRange> >& incoming) {
+            for (BasicBlock& BB : F) {
+                if (!isReachable(BB.getTerminator())) {
+                    continue;
+                }
+
+                for (Instruction& I : BB) {
+                    CallInst* call = dyn_cast<CallInst>(&I);
+                    Function* callee = call ? call->getCalledFunction() : nullptr;
+                    if (!callee || !summaries->count(callee) || call->arg_size() != callee->arg_size()) {
+                        continue;
+                    }
+
+                    vector<VariableRange> arguments(call->arg_size());
+                    for (unsigned i = 0; i < call->arg_size(); ++i) {
+                        getRange(call->getArgOperand(i), call, arguments[i]);
+                    }
+
+                    auto joined = incoming.find(callee);
+                    if (joined == incoming.end()) {
+                        incoming[callee] = arguments;
+                        continue;
+                    }
+                    for (unsigned i = 0; i < arguments.size(); ++i) {
+                        joined->second[i] = unionRange(joined->second[i], arguments[i]);
+                    }
+                }
+            }
+        }
+
+        // ================== END FUNCTION SUMMARIES ================== //
+
+        // ================== BEGIN CHECK ELIMINATION ================== //
+
+        /*
+         * Description:
+         * A block that reports a failed check: it calls a function that does not return, like
+         * __throw_out_of_range_fmt, abort or llvm.trap, and never continues.
+         */
+        bool isCheckFailure(BasicBlock* BB) {
+            for (Instruction& I : *BB) {
+                CallBase* call = dyn_cast<CallBase>(&I);
+                if (call && call->doesNotReturn()) {
+                    return isa<UnreachableInst>(BB->getTerminator()) || BB->getTerminator() == call;
+                }
+            }
+            return false;
+        }
+
+        /*
+         * Description:
+         * Decides the compare icmp right before inst from the operand ranges. Returns false if the
+         * outcome is not known.
+         */
+        bool decideCompare(ICmpInst* icmp, Instruction* inst, bool& result) {
+            VariableRange first, second;
+            if (!icmp->getOperand(0)->getType()->isIntegerTy() ||
+                !getRangeBefore(inst, icmp->getOperand(0), first) ||
+                !getRangeBefore(inst, icmp->getOperand(1), second)) {
+                return false;
+            }
+
+            VariableRange if_lhs, if_rhs, else_lhs, else_rhs;
+            bool if_reachable = false;
+            bool else_reachable = false;
+            refineICmp(icmp, first, second, if_lhs, if_rhs, else_lhs, else_rhs,
+                       if_reachable, else_reachable);
+
+            if (if_reachable == else_reachable) {
+                return false;
+            }
+
+            result = if_reachable;
+            return true;
+        }
+
+        /*
+         * Description:
+         * Finds every runtime check in F whose failure path the ranges prove is never taken. Each one
+         * is the guarding branch and the index of its failing successor. Nothing is changed yet, the
+         * ranges refer to the code as it was analyzed.
+         */
+        vector<pair<BranchInst*, unsigned> > findRedundantChecks(Function& F) {
+            vector<pair<BranchInst*, unsigned> > removable;
+            for (BasicBlock& BB : F) {
+                BranchInst* branch = dyn_cast<BranchInst>(BB.getTerminator());
+                if (!branch || !branch->isConditional() || !isa<ICmpInst>(branch->getCondition())) {
+                    continue;
+                }
+
+                for (unsigned failing = 0; failing < 2; ++failing) {
+                    bool result;
+                    if (isCheckFailure(branch->getSuccessor(failing)) &&
+                        decideCompare(dyn_cast<ICmpInst>(branch->getCondition()), branch, result) &&
+                        result == (failing == 1)) {
+                        removable.push_back({branch, failing});
+                        break;
+                    }
+                }
+            }
+            return removable;
+        }
+
+        /*
+         * Description:
+         * Removes the checks found by findRedundantChecks. The guarding branch becomes unconditional
+         * and the compare and failure block are deleted once nothing uses them.
+         */
+        void removeChecks(const vector<pair<BranchInst*, unsigned> >& removable) {
+            for (auto& check : removable) {
+                BranchInst* branch = check.first;
+                BasicBlock* parent = branch->getParent();
+                BasicBlock* failure = branch->getSuccessor(check.second);
+                BasicBlock* success = branch->getSuccessor(1 - check.second);
+                Value* condition = branch->getCondition();
+
+                // Jump straight to the successful path
+                failure->removePredecessor(parent);
+                BranchInst::Create(success, branch);
+                branch->eraseFromParent();
+                RecursivelyDeleteTriviallyDeadInstructions(condition);
+
+                if (pred_empty(failure)) {
+                    DeleteDeadBlock(failure);
+                }
+            }
+        }
+
+        // ================== END CHECK ELIMINATION ================== //
+
+        // ================== BEGIN RANGE ANNOTATIONS ================== //
+
+        /*
+         * Description:
+         * The range of the value inst defines, on every path that reaches it. Returns false if inst
+         * is not reached or nothing was computed for it.
+         */
+        bool getDefinedRange(Instruction* inst, VariableRange& range) {
+            if (state->gave_up) {
+                return false;
+            }
+
+            const Ranges* ranges = nullptr;
+            if (state->ssa_mode) {
+                ranges = isExecutable(inst->getParent()) ? &state->ssa_ranges : nullptr;
+            }
+            else {
+                // Values are set once per visit of their block, what holds at its end holds for them
+                auto end = state->before_ranges.find(inst->getParent()->getTerminator());
+                ranges = end == state->before_ranges.end() ? nullptr : &end->second;
+            }
+
+            if (!ranges || !ranges->count(inst)) {
+                return false;
+            }
+
+            // Only the locals whose address never escapes hold what was stored to them, any other
+            // memory may be written by a call. Values loaded from it are never written as facts.
+            LoadInst* load = dyn_cast<LoadInst>(inst);
+            if (load && (!isa<AllocaInst>(load->getPointerOperand()) ||
+                         state->escaped_allocas.count(load->getPointerOperand()))) {
+                return false;
+            }
+
+            range = ranges->get(inst);
+            return true;
+        }
+
+        /*
+         * Description:
+         * The operator of the kernel of a binary instruction the ranges model, 0 for any other.
+         */
+        char getKernelOperator(Instruction* inst) {
+            switch (inst->getOpcode()) {
+                case Instruction::SRem :
+                    return '%';
+                case Instruction::URem :
+                    return 'u';
+                case Instruction::UDiv :
+                    return 'd';
+                case Instruction::Shl :
+                    return '<';
+                case Instruction::AShr :
+                    return '>';
+                case Instruction::And :
+                    return '&';
+                case Instruction::Or :
+                    return '|';
+                default:
+                    return getArithmeticOperator(inst);
+            }
+        }
+
+        /*
+         * Description:
+         * The operator of an arithmetic instruction the ranges model, 0 for any other instruction.
+         */
+        char getArithmeticOperator(Instruction* inst) {
+            switch (inst->getOpcode()) {
+                case Instruction::Add :
+                    return '+';
+                case Instruction::Sub :
+                    return '-';
+                case Instruction::Mul :
+                    return '*';
+                case Instruction::SDiv :
+                    return '/';
+                default:
+                    return 0;
+            }
+        }
+
+        /*
+         * Description:
+         * The analysis assumes that no arithmetic wraps and that every constant fits an int. Facts
+         * written into the IR are only true if that holds in F: every reached arithmetic instruction
+         * is nsw, which makes wrapping undefined, or its operand ranges cannot wrap.
+         */
+        bool isWrapFree(Function& F) {
+            for (BasicBlock& BB : F) {
+                if (!isReachable(BB.getTerminator())) {
+                    continue;
+                }
+
+                for (Instruction& I : BB) {
+                    for (Value* operand : I.operands()) {
+                        ConstantInt* constant = dyn_cast<ConstantInt>(operand);
+                        if (constant && constant->getValue().getMinSignedBits() > INT_SIZE) {
+                            return false;
+                        }
+                    }
+
+                    char op = getArithmeticOperator(&I);
+                    if (!op || !I.getType()->isIntegerTy() || (op != '/' && I.hasNoSignedWrap())) {
+                        continue;
+                    }
+
+                    // Narrow integers wrap within their own bits
+                    VariableRange first, second;
+                    if (!getRange(I.getOperand(0), &I, first) || !getRange(I.getOperand(1), &I, second) ||
+                        mayOverflow(first, second, op, getBits(&I))) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /*
+         * Description:
+         * Writes the ranges into F for later optimizations: !range on integer loads and calls, nsw
+         * and nuw on arithmetic that cannot wrap, and llvm.assume on phis. Nothing is written if F
+         * breaks the assumptions of the analysis. Returns true if F changed.
+         */
+        bool annotateRanges(Function& F) {
+            if (!isWrapFree(F)) {
+                LLVM_DEBUG(dbgs() << "BoundsCheck: " << F.getName() << " may wrap, not annotated\n");
+                return false;
+            }
+
+            MDBuilder metadata(F.getContext());
+            vector<pair<PHINode*, VariableRange> > phis;
+            unsigned annotated = 0;
+            for (BasicBlock& BB : F) {
+                for (Instruction& I : BB) {
+                    VariableRange range;
+                    if (!I.getType()->isIntegerTy(INT_SIZE) || !getDefinedRange(&I, range) ||
+                        range == VariableRange()) {
+                        continue;
+                    }
+
+                    // [min, max + 1), wrapping around if max is INT_MAX
+                    if (isa<LoadInst>(&I) || isa<CallInst>(&I)) {
+                        APInt lower(INT_SIZE, range.min_value, true);
+                        APInt upper = APInt(INT_SIZE, range.max_value, true) + 1;
+                        I.setMetadata(LLVMContext::MD_range, metadata.createRange(lower, upper));
+                        ++annotated;
+                    }
+                    else if (isa<PHINode>(&I)) {
+                        phis.push_back({dyn_cast<PHINode>(&I), range});
+                    }
+                }
+
+                // The result range says nothing about wrapping, the operand ranges do
+                for (Instruction& I : BB) {
+                    char op = getArithmeticOperator(&I);
+                    VariableRange first, second;
+                    if (!op || op == '/' || !I.getType()->isIntegerTy(INT_SIZE) ||
+                        !getRange(I.getOperand(0), &I, first) || !getRange(I.getOperand(1), &I, second) ||
+                        mayOverflow(first, second, op)) {
+                        continue;
+                    }
+
+                    bool non_negative = first.min_value >= 0 && second.min_value >= 0;
+                    bool no_unsigned_wrap = non_negative && (op != '-' || first.min_value >= second.max_value);
+                    if (!I.hasNoSignedWrap() || (no_unsigned_wrap && !I.hasNoUnsignedWrap())) {
+                        I.setHasNoSignedWrap(true);
+                        I.setHasNoUnsignedWrap(I.hasNoUnsignedWrap() || no_unsigned_wrap);
+                        ++annotated;
+                    }
+                }
+            }
+
+            // Only calls and loads take !range, phis get their bounds as assumptions
+            for (auto& phi : phis) {
+                IRBuilder<> builder(&*phi.first->getParent()->getFirstInsertionPt());
+                Function* assume = Intrinsic::getDeclaration(F.getParent(), Intrinsic::assume);
+                Type* type = phi.first->getType();
+                if (phi.second.min_value != INT_MIN) {
+                    builder.CreateCall(assume, builder.CreateICmpSGE(phi.first, ConstantInt::get(type, phi.second.min_value, true)));
+                }
+                if (phi.second.max_value != INT_MAX) {
+                    builder.CreateCall(assume, builder.CreateICmpSLE(phi.first, ConstantInt::get(type, phi.second.max_value, true)));
+                }
+                ++annotated;
+            }
+
+            NumValuesAnnotated += annotated;
+            return annotated != 0;
+        }
+
+        // ================== END RANGE ANNOTATIONS ================== //
+
+        // ================== BEGIN RUNTIME GUARDS ================== //
+
+        /*
+         * Description:
+         * The block every failing guard of F branches to. It is created on first use at the end of
+         * the function, so it stays out of the way of the hot code.
+         */
+        BasicBlock* getTrapBlock(Function& F) {
+            if (!state->trap_block) {
+                state->trap_block = BasicBlock::Create(F.getContext(), "bounds.trap", &F);
+                IRBuilder<> builder(state->trap_block);
+                builder.CreateCall(Intrinsic::getDeclaration(F.getParent(), Intrinsic::trap));
+                builder.CreateUnreachable();
+            }
+            return state->trap_block;
+        }
+
+        /*
+         * Description:
+         * A GEP sign extends its indices to the width of pointers. A narrower index is extended the
+         * same way before the guard, so a size that does not fit its type is still compared right.
+         */
+        Value* extendIndex(IRBuilder<>& builder, Instruction* gep, Value* index) {
+            if (!gep->getType()->isPointerTy()) {
+                return index;
+            }
+
+            Type* type = gep->getModule()->getDataLayout().getIntPtrType(gep->getType());
+            if (index->getType()->getScalarSizeInBits() >= type->getScalarSizeInBits()) {
+                return index;
+            }
+            return builder.CreateSExt(index, type, "bounds.index");
+        }
+
+        /*
+         * Description:
+         * Does size fit the type of index as a non-negative value, so an unsigned compare against it
+         * in that type also rejects the negative indices.
+         */
+        bool fitsIndexType(Value* index, int size) {
+            unsigned bits = getBits(index);
+            return bits > INT_SIZE || size <= (1ll << (bits - 1)) - 1;
+        }
+
+        /*
+         * Description:
+         * Splits the block of the array access right before it, and only continues to the access if
+         * its index is in [0, array_size). A single unsigned compare covers both bounds. The trap is
+         * marked as unlikely so it is laid out away from the access.
+         */
+        void insertGuard(const ArrayIndex& guarded) {
+            Instruction* gep = guarded.gep;
+            Value* index = gep->getOperand(guarded.operand);
+            BasicBlock* parent = gep->getParent();
+            BasicBlock* access = parent->splitBasicBlock(gep, parent->getName() + ".inbounds");
+            BasicBlock* trap = getTrapBlock(*parent->getParent());
+
+            // Replace the unconditional branch left by the split with the guard
+            Instruction* split_branch = parent->getTerminator();
+            IRBuilder<> builder(split_branch);
+            index = extendIndex(builder, gep, index);
+            Value* in_bounds = builder.CreateICmpULT(index, ConstantInt::get(index->getType(), guarded.array_size),
+                                                     "bounds.ok");
+            MDBuilder weights(gep->getContext());
+            builder.CreateCondBr(in_bounds, access, trap, weights.createBranchWeights(GUARD_LIKELY_WEIGHT, 1));
+            split_branch->eraseFromParent();
+        }
+
+        /*
+         * Description:
+         * Guards every array access of the function that is not proven to be in bounds, including the
+         * ones that are always out of bounds. The proven ones are left as they are. Returns the number
+         * of guards inserted.
+         */
+        unsigned insertGuards() {
+            unsigned guarded = 0;
+            for (const ArrayIndex& access : state->unproven_accesses) {
+                if (access.gep->getOperand(access.operand)->getType()->isIntegerTy()) {
+                    insertGuard(access);
+                    ++guarded;
+                }
+            }
+            return guarded;
+        }
+
+        // ================== END RUNTIME GUARDS ================== //
+
+        // ================== BEGIN LOOP GUARD HOISTING ================== //
+
+        // An array access whose index is affine in the induction variable of its loop
+        struct AffineAccess {
+            ArrayIndex index;
+
+            // Index on the first iteration and the last one that can reach the access
+            const SCEV* first;
+            const SCEV* last;
+        };
+
+        /*
+         * Description:
+         * Can bound be computed right before loop L. It may only depend on values defined outside of
+         * every loop, so versioning other loops of the function never moves what it depends on.
+         */
+        bool isHoistable(const SCEV* bound, Loop* L) {
+            ScalarEvolution* SE = state->scalar_evolution;
+            bool loop_dependent = SCEVExprContains(bound, [&](const SCEV* expr) {
+                if (isa<SCEVAddRecExpr>(expr)) {
+                    return true;
+                }
+
+                const SCEVUnknown* unknown = dyn_cast<SCEVUnknown>(expr);
+                Instruction* inst = unknown ? dyn_cast<Instruction>(unknown->getValue()) : nullptr;
+                return inst && state->loop_info->getLoopFor(inst->getParent());
+            });
+
+            return !loop_dependent && SE->isLoopInvariant(bound, L) &&
+                   isSafeToExpandAt(bound, L->getLoopPreheader()->getTerminator(), *SE);
+        }
+
+        /*
+         * Description:
+         * The first and last value the index of the array access can take in its loop L, if the
+         * index is an affine induction variable of L that does not wrap. As the index moves in one
+         * direction, it stays in bounds on every iteration if both of these are in bounds.
+         */
+        bool getAffineBounds(const ArrayIndex& access, Loop* L, const SCEV*& first, const SCEV*& last) {
+            ScalarEvolution* SE = state->scalar_evolution;
+            Instruction* gep = access.gep;
+            const SCEVAddRecExpr* index = dyn_cast<SCEVAddRecExpr>(SE->getSCEV(gep->getOperand(access.operand)));
+            if (!index || index->getLoop() != L || !index->isAffine() || !index->hasNoSignedWrap()) {
+                return false;
+            }
+
+            const SCEV* taken = SE->getBackedgeTakenCount(L);
+            if (isa<SCEVCouldNotCompute>(taken)) {
+                return false;
+            }
+
+            // When only the header exits, the rest of the body runs one time less than the header
+            const SCEV* iterations = taken;
+            if (L->getExitingBlock() == L->getHeader() && gep->getParent() != L->getHeader()) {
+                iterations = SE->getMinusSCEV(taken, SE->getOne(taken->getType()));
+            }
+            iterations = SE->getTruncateOrZeroExtend(iterations, index->getType());
+
+            first = index->getStart();
+            last = index->evaluateAtIteration(iterations, *SE);
+            return isHoistable(first, L) && isHoistable(last, L);
+        }
+
+        /*
+         * Description:
+         * Moves the unproven accesses whose index is affine in their innermost loop from the accesses
+         * guarded on every iteration to the loop they can be checked before. Those scalar evolution
+         * proves in bounds need no check at all. With block frequencies, only hot accesses move.
+         */
+        void planHoisting() {
+            vector<ArrayIndex> per_iteration;
+            for (const ArrayIndex& access : state->unproven_accesses) {
+                Instruction* gep = access.gep;
+                Value* index = gep->getOperand(access.operand);
+                Loop* L = state->loop_info->getLoopFor(gep->getParent());
+
+                // Versioning a loop for an access that always fails would only run the checked copy
+                VariableRange range;
+                bool out_of_bounds = getRangeBefore(gep, index, range) && outOfRange(range, access.array_size);
+
+                const SCEV* first;
+                const SCEV* last;
+                if (!L || out_of_bounds || !L->getLoopPreheader() || !L->hasDedicatedExits() || !L->isSafeToClone() ||
+                    !index->getType()->isIntegerTy() || !fitsIndexType(index, access.array_size) ||
+                    !getAffineBounds(access, L, first, last)) {
+                    per_iteration.push_back(access);
+                    continue;
+                }
+
+                ScalarEvolution* SE = state->scalar_evolution;
+                const SCEV* size = SE->getConstant(first->getType(), access.array_size);
+                if (SE->isKnownNonNegative(first) && SE->isKnownNonNegative(last) &&
+                    SE->isKnownPredicate(ICmpInst::ICMP_SLT, first, size) &&
+                    SE->isKnownPredicate(ICmpInst::ICMP_SLT, last, size)) {
+                    ++state->num_proven_safe;
+                    --state->num_unproven;
+                    continue;
+                }
+
+                // Copying a loop that rarely runs costs more code than its checks cost time
+                if (block_frequency && !isHot(gep->getParent())) {
+                    per_iteration.push_back(access);
+                    continue;
+                }
+
+                state->hoisted_accesses[L].push_back({access, first, last});
+            }
+            state->unproven_accesses = per_iteration;
+        }
+
+        /*
+         * Description:
+         * Splits loop L into two copies. The bounds of accesses are checked once in front of L, if
+         * they hold L runs as it is, otherwise a checked copy of it runs. VMap maps the values of L
+         * to their copies.
+         */
+        void versionLoop(Loop* L, const vector<AffineAccess>& accesses, ValueToValueMapTy& VMap) {
+            DominatorTree* DT = state->dom_tree;
+            LoopInfo* LI = state->loop_info;
+            ScalarEvolution* SE = state->scalar_evolution;
+
+            // Values of L used after it get a phi in its exits, which then merges both copies
+            formLCSSA(*L, *DT, LI, SE);
+
+            BasicBlock* check = L->getLoopPreheader();
+            BasicBlock* preheader = SplitBlock(check, check->getTerminator(), DT, LI);
+
+            SmallVector<BasicBlock*, 8> blocks;
+            cloneLoopWithPreheader(preheader, check, L, VMap, ".checked", LI, DT, blocks);
+            remapInstructionsInBlocks(blocks, VMap);
+
+            // The exits are now also reached from the checked copy
+            SmallVector<BasicBlock*, 4> exits;
+            L->getUniqueExitBlocks(exits);
+            for (BasicBlock* exit : exits) {
+                for (PHINode& phi : exit->phis()) {
+                    for (unsigned i = 0, e = phi.getNumIncomingValues(); i < e; ++i) {
+                        if (!L->contains(phi.getIncomingBlock(i))) {
+                            continue;
+                        }
+
+                        Value* incoming = phi.getIncomingValue(i);
+                        auto mapped = VMap.find(incoming);
+                        phi.addIncoming(mapped == VMap.end() ? incoming : static_cast<Value*>(mapped->second),
+                                        cast<BasicBlock>(VMap[phi.getIncomingBlock(i)]));
+                    }
+                }
+            }
+
+            // Check the first and last index of every access at once
+            Instruction* split_branch = check->getTerminator();
+            SCEVExpander expander(*SE, check->getModule()->getDataLayout(), "bounds");
+            IRBuilder<> builder(split_branch);
+            Value* in_bounds = nullptr;
+            for (const AffineAccess& access : accesses) {
+                for (const SCEV* bound : {access.first, access.last}) {
+                    Value* index = expander.expandCodeFor(bound, bound->getType(), split_branch);
+                    Value* bound_ok = builder.CreateICmpULT(index, ConstantInt::get(index->getType(), access.index.array_size),
+                                                            "bounds.ok");
+                    // Bounds like a constant start fold away
+                    if (isa<ConstantInt>(bound_ok) && dyn_cast<ConstantInt>(bound_ok)->isOne()) {
+                        continue;
+                    }
+                    in_bounds = in_bounds ? builder.CreateAnd(in_bounds, bound_ok, "bounds.ok") : bound_ok;
+                }
+            }
+            if (!in_bounds) {
+                in_bounds = builder.getTrue();
+            }
+
+            MDBuilder weights(check->getContext());
+            builder.CreateCondBr(in_bounds, preheader, cast<BasicBlock>(VMap[preheader]),
+                                 weights.createBranchWeights(GUARD_LIKELY_WEIGHT, 1));
+            split_branch->eraseFromParent();
+
+            // The exits now merge both copies, which moves their dominators
+            DT->recalculate(*check->getParent());
+            SE->forgetLoop(L);
+        }
+
+        /*
+         * Description:
+         * Versions every loop with hoisted accesses. The unchecked copy keeps no guard for them, the
+         * checked copy guards them on every iteration like the accesses that could not be hoisted,
+         * which are guarded in both copies. Returns the number of accesses hoisted.
+         */
+        unsigned versionLoops() {
+            unsigned hoisted = 0;
+            for (auto& loop : state->hoisted_accesses) {
+                ValueToValueMapTy VMap;
+                versionLoop(loop.first, loop.second, VMap);
+
+                unsigned num_unproven = state->unproven_accesses.size();
+                for (unsigned i = 0; i < num_unproven; ++i) {
+                    ArrayIndex access = state->unproven_accesses[i];
+                    if (loop.first->contains(access.gep)) {
+                        state->unproven_accesses.push_back({cast<Instruction>(VMap[access.gep]), access.operand,
+                                                            access.array_size});
+                    }
+                }
+
+                for (const AffineAccess& access : loop.second) {
+                    state->unproven_accesses.push_back({cast<Instruction>(VMap[access.index.gep]), access.index.operand,
+                                                        access.index.array_size});
+                }
+                hoisted += loop.second.size();
+            }
+            return hoisted;
+        }
+
+        // ================== END LOOP GUARD HOISTING ================== //
+
+        // ================== BEGIN SSA RANGE ANALYSIS ================== //
+
+        /*
+         * Description:
+         * Decides if F is analyzed in SSA form. In auto mode that is the case once every scalar
+         * variable was promoted to a register (mem2reg/SROA), so only arrays are left in memory.
+         * Locals whose address escapes are never promoted, and memory mode knows nothing about
+         * them either, so they do not keep F in memory mode.
+         */
+        bool useSSAMode(Function& F) {
+            if (Mode != MODE_AUTO) {
+                return Mode == MODE_SSA;
+            }
+
+            for (BasicBlock& BB : F) {
+                for (Instruction& I : BB) {
+                    AllocaInst* alloca = dyn_cast<AllocaInst>(&I);
+                    if (alloca && !alloca->getAllocatedType()->isArrayTy() && !state->escaped_allocas.count(alloca)) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /*
+         * Description:
+         * Is it possible to reach BB from the entry, given what is known so far.
+         */
+        bool isExecutable(BasicBlock* BB) {
+            auto index = state->rpo_index.find(BB);
+            return index != state->rpo_index.end() && state->executable[index->second];
+        }
+
+        /*
+         * Description:
+         * The ranges refined on the edge from pred to succ, null if the edge is not executable.
+         */
+        const Ranges* getEdgeRanges(BasicBlock* pred, BasicBlock* succ) {
+            auto succ_ranges = state->bb_to_succ_ranges.find(pred);
+            if (succ_ranges == state->bb_to_succ_ranges.end()) {
+                return nullptr;
+            }
+
+            auto ranges = succ_ranges->second.find(succ);
+            return ranges == succ_ranges->second.end() ? nullptr : &ranges->second;
+        }
+
+        /*
+         * Description:
+         * The range of val where it is used in BB. The closest edge that dominates BB and refines val,
+         * because it is guarded by a compare on val, narrows the range (a pi node). Returns false if
+         * nothing is known about val yet.
+         */
+        bool getRangeAt(Value* val, BasicBlock* BB, VariableRange& range) {
+            if (isa<ConstantInt>(val)) {
+                ConstantInt* constant = dyn_cast<ConstantInt>(val);
+                int value = clampConstant(constant->getValue());
+                range = {value, value};
+                return true;
+            }
+
+            // Values that are never tracked, like undef or globals, could be anything
+            if (!state->numbering.contains(val)) {
+                range = VariableRange();
+                return true;
+            }
+
+            if (!state->ssa_ranges.count(val)) {
+                return false;
+            }
+
+            range = state->ssa_ranges.get(val);
+            Instruction* def = dyn_cast<Instruction>(val);
+            BasicBlock* def_block = def ? def->getParent() : nullptr;
+
+            // Walk up the dominator tree until the definition of val
+            for (DomTreeNode* node = state->dom_tree->getNode(BB); node && node->getBlock() != def_block;
+                 node = node->getIDom()) {
+                BasicBlock* block = node->getBlock();
+                BasicBlock* pred = block->getSinglePredecessor();
+                if (!pred) {
+                    continue;
+                }
+
+                const Ranges* refined = getEdgeRanges(pred, block);
+                if (refined && refined->count(val)) {
+                    range = refined->get(val);
+                    break;
+                }
+            }
+            return true;
+        }
+
+        /*
+         * Description:
+         * Queues inst to be visited by the SSA solver.
+         */
+        void pushSSAWorklist(Instruction* inst) {
+            if (isExecutable(inst->getParent())) {
+                state->ssa_worklist.insert(inst);
+            }
+        }
+
+        /*
+         * Description:
+         * The range of val changed, queue every instruction that uses it. Only instructions and
+         * arguments change, a constant like i32 0 is used all over the module.
+         */
+        void pushUsers(Value* val) {
+            if (!isa<Instruction>(val) && !isa<Argument>(val)) {
+                return;
+            }
+
+            for (User* user : val->users()) {
+                if (isa<Instruction>(user)) {
+                    pushSSAWorklist(dyn_cast<Instruction>(user));
+                }
+            }
+        }
+
+        /*
+         * Description:
+         * Records refined as the ranges on the edge from pred to succ and makes the edge executable.
+         * Returns true if the edge is new or its ranges changed.
+         */
+        bool updateSSAEdge(BasicBlock* pred, BasicBlock* succ, const Ranges& refined) {
+            unordered_map<BasicBlock*, Ranges>& succ_ranges = state->bb_to_succ_ranges[pred];
+            auto previous = succ_ranges.find(succ);
+            if (previous != succ_ranges.end() && equal_ranges(refined, previous->second)) {
+                return false;
+            }
+            succ_ranges[succ] = refined;
+
+            // A block reached for the first time is visited as a whole, otherwise only its phis
+            // have to look at the edge again.
+            if (!isExecutable(succ)) {
+                state->executable[state->rpo_index[succ]] = true;
+                pushWorklist(succ);
+            }
+            else {
+                for (PHINode& phi : succ->phis()) {
+                    pushSSAWorklist(&phi);
+                }
+            }
+            return true;
+        }
+
+        /*
+         * Description:
+         * Determine which successors of a branch are reachable and refine the compared values on
+         * each edge. If an edge changed, every use of the compared values is visited again.
+         */
+        void handleSSABranch(BranchInst* branch) {
+            BasicBlock* parent = branch->getParent();
+            Ranges if_ranges(state->numbering);
+            Ranges else_ranges(state->numbering);
+
+            if (branch->isUnconditional()) {
+                updateSSAEdge(parent, branch->getSuccessor(0), if_ranges);
+                return;
+            }
+
+            bool if_reachable = true;
+            bool else_reachable = true;
+
+            ICmpInst* icmp = dyn_cast<ICmpInst>(branch->getCondition());
+            bool refine = icmp && icmp->getOperand(0)->getType()->isIntegerTy();
+            if (refine) {
+                Value* firstVal = icmp->getOperand(0);
+                Value* secondVal = icmp->getOperand(1);
+
+                // Wait until both sides of the compare are known
+                VariableRange first, second;
+                if (!getRangeAt(firstVal, parent, first) || !getRangeAt(secondVal, parent, second)) {
+                    return;
+                }
+
+                VariableRange if_lhs, if_rhs, else_lhs, else_rhs;
+                refineICmp(icmp, first, second, if_lhs, if_rhs, else_lhs, else_rhs,
+                           if_reachable, else_reachable);
+
+                // Constants are not refined
+                if (!isa<Constant>(firstVal)) {
+                    if_ranges.set(firstVal, if_lhs);
+                    else_ranges.set(firstVal, else_lhs);
+                }
+
+                if (!isa<Constant>(secondVal)) {
+                    if_ranges.set(secondVal, if_rhs);
+                    else_ranges.set(secondVal, else_rhs);
+                }
+            }
+
+            bool changed = false;
+            if (if_reachable) {
+                changed = updateSSAEdge(parent, branch->getSuccessor(0), if_ranges) || changed;
+            }
+
+            if (else_reachable) {
+                changed = updateSSAEdge(parent, branch->getSuccessor(1), else_ranges) || changed;
+            }
+
+            if (changed && refine) {
+                pushUsers(icmp->getOperand(0));
+                pushUsers(icmp->getOperand(1));
+            }
+        }
+
+        /*
+         * Description:
+         * Asks scalar evolution for the range of every induction variable of a loop header. Its start,
+         * step and trip count give the values on all iterations, so such a phi gets its final range on
+         * the first visit instead of being widened.
+         */
+        void seedInductionVariables(Function& F) {
+            ScalarEvolution* SE = state->scalar_evolution;
+            for (BasicBlock& BB : F) {
+                Loop* L = state->loop_info->getLoopFor(&BB);
+                if (!L || L->getHeader() != &BB) {
+                    continue;
+                }
+
+                for (PHINode& phi : BB.phis()) {
+                    // Wider integers are clamped to the int ranges tracked
+                    if (!phi.getType()->isIntegerTy()) {
+                        continue;
+                    }
+
+                    const SCEVAddRecExpr* induction = dyn_cast<SCEVAddRecExpr>(SE->getSCEV(&phi));
+                    if (!induction || induction->getLoop() != L || !induction->isAffine()) {
+                        continue;
+                    }
+
+                    ConstantRange range = SE->getSignedRange(induction);
+                    if (range.isFullSet()) {
+                        continue;
+                    }
+
+                    state->induction_ranges[&phi] = {clampConstant(range.getSignedMin()),
+                                                     clampConstant(range.getSignedMax())};
+                    ++NumInductionVariablesSeeded;
+                }
+            }
+        }
+
+        /*
+         * Description:
+         * Joins the ranges of all incoming values of phi on executable edges. At loop headers the
+         * result also covers the previous range and is widened, unless phi is an induction variable
+         * whose range is known up front or the solver is narrowing. Returns false if no incoming
+         * value is known yet.
+         */
+        bool handlePhi(PHINode* phi, VariableRange& range) {
+            BasicBlock* parent = phi->getParent();
+            bool known = false;
+
+            for (unsigned i = 0; i < phi->getNumIncomingValues(); ++i) {
+                BasicBlock* pred = phi->getIncomingBlock(i);
+                const Ranges* edge = getEdgeRanges(pred, parent);
+                if (!edge) {
+                    continue;
+                }
+
+                // The edge itself may refine the incoming value
+                Value* val = phi->getIncomingValue(i);
+                VariableRange incoming;
+                if (edge->count(val)) {
+                    incoming = edge->get(val);
+                }
+                else if (!getRangeAt(val, pred, incoming)) {
+                    continue;
+                }
+
+                range = known ? unionRange(range, incoming) : incoming;
+                known = true;
+            }
+
+            // Induction variables already cover every iteration of their loop
+            auto seed = state->induction_ranges.find(phi);
+            if (known && seed != state->induction_ranges.end()) {
+                range = seed->second;
+                return true;
+            }
+
+            if (known && !state->narrowing && state->ssa_ranges.count(phi) && isLoopHeader(parent)) {
+                VariableRange previous = state->ssa_ranges.get(phi);
+                VariableRange joined = unionRange(previous, range);
+                range = widenRange(previous, joined, state->thresholds);
+                state->widenings += !(range == joined);
+            }
+            return known;
+        }
+
+        /*
+         * Description:
+         * Computes the range of the SSA value defined by inst from the ranges of its operands. If the
+         * range changed, all users are queued.
+         */
+        void visitSSA(Instruction* inst) {
+            if (state->demand_driven && !isDemanded(inst)) {
+                return;
+            }
+            ++state->solver_iterations;
+            ++state->instructions_transferred;
+            BasicBlock* parent = inst->getParent();
+            VariableRange range;
+            VariableRange first, second;
+
+            switch (inst->getOpcode()) {
+                case Instruction::PHI :
+                    if (!handlePhi(dyn_cast<PHINode>(inst), range)) {
+                        return;
+                    }
+                    break;
+                case Instruction::Add :
+                case Instruction::Sub :
+                case Instruction::SDiv :
+                case Instruction::Mul :
+                case Instruction::SRem :
+                case Instruction::URem :
+                case Instruction::UDiv :
+                case Instruction::Shl :
+                case Instruction::AShr :
+                case Instruction::And :
+                case Instruction::Or : {
+                    if (!getRangeAt(inst->getOperand(0), parent, first) ||
+                        !getRangeAt(inst->getOperand(1), parent, second)) {
+                        return;
+                    }
+                    range = binaryRange(first, second, getKernelOperator(inst), getBits(inst));
+                    break;
+                }
+                case Instruction::Trunc :
+                case Instruction::ZExt :
+                case Instruction::SExt :
+                    if (!getRangeAt(inst->getOperand(0), parent, first)) {
+                        return;
+                    }
+                    range = castRange(inst, first);
+                    break;
+                case Instruction::Select :
+                    if (!getRangeAt(inst->getOperand(1), parent, first) ||
+                        !getRangeAt(inst->getOperand(2), parent, second)) {
+                        return;
+                    }
+                    range = unionRange(first, second);
+                    break;
+                case Instruction::Call : {
+                    // Nothing is assumed about calls, unless the callee has a summary
+                    CallInst* call = dyn_cast<CallInst>(inst);
+                    if (!hasSummary(call)) {
+                        if (inst->getType()->isVoidTy()) {
+                            return;
+                        }
+                        getLibraryCallRange(call, range);
+                        break;
+                    }
+
+                    vector<VariableRange> arguments(call->arg_size());
+                    for (unsigned i = 0; i < call->arg_size(); ++i) {
+                        if (!getRangeAt(call->getArgOperand(i), parent, arguments[i])) {
+                            return;
+                        }
+                    }
+                    range = getCallRange(call, arguments);
+                    break;
+                }
+                case Instruction::ICmp :
+                    // Branches refine the compared values themselves, the result is a flag like
+                    // any other i1: true is -1
+                    range = {-1, 0};
+                    break;
+                case Instruction::Br :
+                    handleSSABranch(dyn_cast<BranchInst>(inst));
+                    return;
+                default:
+                    // Any other terminator may go to all of its successors. What an invoke returns
+                    // could be anything.
+                    if (inst->isTerminator()) {
+                        if (!inst->getType()->isVoidTy() && !state->ssa_ranges.count(inst)) {
+                            state->ssa_ranges.set(inst, VariableRange());
+                            pushUsers(inst);
+                        }
+
+                        Ranges nothing_refined(state->numbering);
+                        for (unsigned i = 0; i < inst->getNumSuccessors(); ++i) {
+                            updateSSAEdge(parent, inst->getSuccessor(i), nothing_refined);
+                        }
+                        return;
+                    }
+
+                    // Nothing is assumed about loads, calls or arrays
+                    if (inst->getType()->isVoidTy()) {
+                        return;
+                    }
+                    break;
+            }
+
+            if (state->ssa_ranges.count(inst) && state->ssa_ranges.get(inst) == range) {
+                return;
+            }
+
+            state->ssa_ranges.set(inst, range);
+            pushUsers(inst);
+        }
+
+        /*
+         * Description:
+         * Sparse range propagation over SSA values. Every value has one range, refined on the edges
+         * leaving a compare. Instructions are only visited again when one of their operands, or an
+         * edge refining one, changed, so the cost follows the number of definitions.
+         */
+        void runSSASolver(Function& F) {
+            state->ssa_ranges = Ranges(state->numbering);
+            state->executable.assign(state->rpo_blocks.size(), false);
+
+            // Nothing is known about the arguments, unless all callers are known
+            for (Argument& arg : F.args()) {
+                state->ssa_ranges.set(&arg, getArgumentRange(&arg));
+            }
+
+            state->executable[state->rpo_index[&F.getEntryBlock()]] = true;
+            pushWorklist(&F.getEntryBlock());
+
+            while ((!state->worklist.empty() || !state->ssa_worklist.empty()) && !overBudget()) {
+                // Propagate changed values first, then visit newly reached blocks
+                if (!state->ssa_worklist.empty()) {
+                    visitSSA(state->ssa_worklist.pop_back_val());
+                    continue;
+                }
+
+                unsigned index = state->worklist.top();
+                state->worklist.pop();
+                state->in_worklist[index] = false;
+
+                ++state->blocks_visited;
+                for (Instruction& I : *state->rpo_blocks[index]) {
+                    visitSSA(&I);
+                }
+            }
+        }
+
+        /*
+         * Description:
+         * Like narrowMemory, visits every instruction of the reached blocks again without widening
+         * for a few rounds, or until a round changes no value and no edge.
+         */
+        void narrowSSA() {
+            state->narrowing = true;
+            for (unsigned round = 0; round < NarrowingRounds; ++round) {
+                clearWorklists();
+                for (BasicBlock* BB : state->rpo_blocks) {
+                    if (isExecutable(BB)) {
+                        ++state->blocks_visited;
+                        for (Instruction& I : *BB) {
+                            visitSSA(&I);
                         }
                     }
+                }
+
+                if (state->ssa_worklist.empty() && state->worklist.empty()) {
+                    break;
+                }
+            }
+            clearWorklists();
+        }
+
+        // ================== END SSA RANGE ANALYSIS ================== //
+
+        /*
+         * Description:
+         * Main code of the algorithm. Computes the ranges of F and checks its array accesses.
+         * Everything of the previous function is dropped first. DT, LI and SE have to stay valid for
+         * as long as the results are used.
+         */
+        void analyze(Function& F, DominatorTree& DT, LoopInfo& LI, ScalarEvolution& SE) {
+            prepare(F, DT, LI, SE);
+            solve(F);
+        }
+
+        /*
+         * Description:
+         * The first half of analyze, everything that may add to the LLVMContext: scalar evolution
+         * creates constants, and the data layout caches type layouts. Has to run on the thread that
+         * owns the context.
+         */
+        void prepare(Function& F, DominatorTree& DT, LoopInfo& LI, ScalarEvolution& SE) {
+            // Reset per function state. Necessary since this carries over between functions, all
+            // of the range versions of the previous function are released with its arena.
+            state.reset(new FunctionState());
+
+            // Number the tracked values and order the blocks for the worklist
+            state->start_time = std::chrono::steady_clock::now();
+            state->demand_driven = DemandDriven;
+            {
+                PhaseTimer timer("order", "Numbering values and ordering blocks", timePhases());
+                numberValues(F);
+                collectEscapedAllocas(F);
+                createBlockOrder(F);
+                collectThresholds(F);
+            }
+
+            // Without array accesses there is nothing to check, unless a transform needs the ranges
+            if (state->demand_driven && !state->has_array_accesses && !summaries && !EliminateChecks &&
+                !AnnotateRanges) {
+                state->gave_up = true;
+                state->skipped = true;
+                ++NumFunctionsSkipped;
+            }
+
+            // Too many values to even start, every access is unproven
+            if (MaxTrackedValues && state->numbering.size() > MaxTrackedValues) {
+                giveUp();
+            }
+
+            state->ssa_mode = useSSAMode(F);
+            state->dom_tree = &DT;
+            state->loop_info = &LI;
+            state->scalar_evolution = &SE;
+            if (state->ssa_mode && !state->gave_up) {
+                PhaseTimer timer("seed", "Seeding induction variables", timePhases());
+                seedInductionVariables(F);
+            }
+
+            // Get all of the arrays
+            PhaseTimer timer("arrays", "Collecting array sizes", timePhases());
+            getArrayInformation(F);
+        }
+
+        /*
+         * Description:
+         * The second half of analyze, runs the solver and checks the accesses. Only reads the IR and
+         * the analyses, so functions prepared before can be solved on several threads at once.
+         */
+        void solve(Function& F) {
+            if (state->skipped) {
+                return;
+            }
+
+            {
+                PhaseTimer timer("solve", "Solving the ranges", timePhases());
+                runSolver(F);
+            }
+
+            LLVM_DEBUG(dbgs() << "BoundsCheck: " << F.getName() << " converged after "
+                              << state->solver_iterations << " block visits\n");
+            ++NumFunctionsAnalyzed;
+            NumBlocksVisited += state->blocks_visited;
+            NumSolverIterations += state->solver_iterations;
+            NumInstructionsTransferred += state->instructions_transferred;
+            NumWidenings += state->widenings;
+
+            // Check to see if range is out of bounds
+            PhaseTimer timer("check", "Checking array accesses", timePhases());
+            checkArrayBounds(F);
+        }
+
+        /*
+         * Description:
+         * Runs the solver of the mode of F to a fixed point, then narrows.
+         */
+        void runSolver(Function& F) {
+            if (state->ssa_mode && !state->gave_up) {
+                runSSASolver(F);
+            }
+
+            // Visit blocks until no edge state changes anymore. A block is only queued again when the
+            // state on one of its incoming edges changed.
+            pushWorklist(&F.getEntryBlock());
+            while (!state->ssa_mode && !state->worklist.empty() && !overBudget()) {
+                // Get the next bb in reverse post-order
+                unsigned index = state->worklist.top();
+                state->worklist.pop();
+                state->in_worklist[index] = false;
+                ++state->solver_iterations;
+                visitBlock(state->rpo_blocks[index]);
+            }
+
+            // Win back the loop bounds widening gave up
+            if (state->gave_up) {
+                // Nothing to narrow
+            }
+            else if (state->ssa_mode) {
+                narrowSSA();
+            }
+            else {
+                narrowMemory();
+            }
+        }
+
+        /*
+         * Description:
+         * Reports what checkArrayBounds found in F: a warning about every array access that is
+         * always out of bounds, and in the structured formats the unproven accesses as well. With
+         * block frequencies, the accesses are ranked by how often they run.
+         */
+        void reportAccesses(Function& F) {
+            BoundsCheckReport::Counts counts;
+            counts.num_functions = 1;
+            counts.num_proven_safe = state->num_proven_safe;
+            counts.num_unproven = state->num_unproven;
+            counts.num_out_of_bounds = state->num_out_of_bounds;
+            counts.num_given_up = state->gave_up && !state->skipped;
+
+            // The accesses that run most often come first
+            vector<AccessFinding> ranked = state->findings;
+            if (block_frequency) {
+                std::stable_sort(ranked.begin(), ranked.end(), [&](const AccessFinding& a, const AccessFinding& b) {
+                    return block_frequency->getBlockFreq(a.access->getParent()).getFrequency() >
+                           block_frequency->getBlockFreq(b.access->getParent()).getFrequency();
+                });
+            }
+
+            vector<BoundsCheckFinding> findings;
+            for (const AccessFinding& finding : ranked) {
+                findings.push_back(describeFinding(finding));
+                if (block_frequency) {
+                    findings.back().execution_count = getExecutionCount(finding.access->getParent());
+                }
+            }
+            getReport().addFunction(F, counts, findings);
+        }
+
+        /*
+         * Description:
+         * Send the warnings to report and count the accesses of every function reported there.
+         * Without a report, they go where the options of the passes say.
+         */
+        void setReport(BoundsCheckReport* function_report) {
+            report = function_report;
+        }
+
+        /*
+         * Description:
+         * Use the frequencies of BFI for the next function analyzed, nothing if it is null. BFI has
+         * to belong to that function and stay valid until it is transformed.
+         */
+        void setBlockFrequency(BlockFrequencyInfo* BFI) {
+            block_frequency = BFI;
+        }
+
+        /*
+         * Description:
+         * The number of threads analyzers solve on at the same time, the size of the pool of the
+         * module mode. The phases are only timed on one.
+         */
+        void setSolverThreads(unsigned threads) {
+            solver_threads = threads;
+        }
+
+        bool timePhases() const {
+            return TimePassesIsEnabled && solver_threads <= 1;
+        }
+
+        /*
+         * Description:
+         * What checkArrayBounds found in F, for the result cache.
+         */
+        CachedResult getCachedResult(Function& F) {
+            unordered_map<Instruction*, uint32_t> positions;
+            uint32_t position = 0;
+            for (Instruction& I : instructions(F)) {
+                positions[&I] = position++;
+            }
+
+            CachedResult result;
+            result.num_proven_safe = state->num_proven_safe;
+            result.num_unproven = state->num_unproven;
+            result.num_out_of_bounds = state->num_out_of_bounds;
+            for (const AccessFinding& finding : state->findings) {
+                result.findings.push_back({positions[finding.access], finding.array_size, finding.index.min_value,
+                                           finding.index.max_value, finding.out_of_bounds});
+            }
+            return result;
+        }
+
+        /*
+         * Description:
+         * Takes the result of checkArrayBounds for F from the cache instead of analyzing it. Only the
+         * findings are known afterwards, no ranges. Returns false if result does not fit F.
+         */
+        bool restoreCachedResult(Function& F, const CachedResult& result) {
+            state.reset(new FunctionState());
+            vector<Instruction*> by_position;
+            for (Instruction& I : instructions(F)) {
+                by_position.push_back(&I);
+            }
+
+            for (const CachedFinding& finding : result.findings) {
+                if (finding.position >= by_position.size()) {
+                    return false;
+                }
+                state->findings.push_back({by_position[finding.position], finding.array_size,
+                                           VariableRange{finding.index_min, finding.index_max},
+                                           finding.out_of_bounds != 0});
+            }
+
+            state->num_proven_safe = result.num_proven_safe;
+            state->num_unproven = result.num_unproven;
+            state->num_out_of_bounds = result.num_out_of_bounds;
+            return true;
+        }
+
+        /*
+         * Description:
+         * Instruments the accesses of F that are not proven safe. Accesses affine in a loop are
+         * checked once in front of it and the loop is versioned. Returns true if F changed.
+         */
+        bool guardAccesses(Function& F) {
+            if (HoistGuards) {
+                planHoisting();
+
+                unsigned hoisted = versionLoops();
+                NumGuardsHoisted += hoisted;
+                NumLoopsVersioned += state->hoisted_accesses.size();
+                if (hoisted) {
+                    getOutput() << F.getName() << ": hoisted " << hoisted << " guards out of "
+                           << state->hoisted_accesses.size() << " loops.\n";
+                }
+            }
+
+            unsigned guarded = insertGuards();
+            NumAccessesGuarded += guarded;
+            getOutput() << F.getName() << ": " << state->num_proven_safe << " accesses proven safe, "
+                   << state->num_unproven << " guarded, " << state->num_out_of_bounds
+                   << " out of bounds.\n";
+            return guarded != 0;
+        }
+
+        /*
+         * Description:
+         * Removes the runtime checks of F that findRedundantChecks found. Returns true if F changed.
+         */
+        bool eliminateChecks(Function& F, const vector<pair<BranchInst*, unsigned> >& removable) {
+            removeChecks(removable);
+            NumChecksEliminated += removable.size();
+            if (!removable.empty()) {
+                getOutput() << F.getName() << ": removed " << removable.size() << " bounds checks.\n";
+            }
+            return !removable.empty();
+        }
+
+        /*
+         * Description:
+         * The range of val where ctx uses it. In memory mode, a ctx the solver kept no state for is
+         * answered from the state at the end of its block: values are set once per visit of their
+         * block, and the operands of ctx before it, so they hold what they held there. Only the
+         * value of a local changes within the block, through the stores before ctx. Nothing of the
+         * solver is changed. Returns false if ctx is not reachable.
+         */
+        bool getRange(Value* val, Instruction* ctx, VariableRange& range) {
+            if (state->gave_up || state->ssa_mode || state->before_ranges.count(ctx)) {
+                return getRangeBefore(ctx, val, range);
+            }
+
+            BasicBlock* parent = ctx->getParent();
+            auto end = state->before_ranges.find(parent->getTerminator());
+            if (!state->basic_block_before_ranges.count(parent) || end == state->before_ranges.end()) {
+                return false;
+            }
+
+            if (isa<ConstantInt>(val)) {
+                int value = clampConstant(dyn_cast<ConstantInt>(val)->getValue());
+                range = {value, value};
+                return true;
+            }
+
+            if (!isa<AllocaInst>(val)) {
+                range = end->second.get(val);
+                return true;
+            }
+
+            range = state->basic_block_before_ranges[parent].get(val);
+            for (Instruction& I : *parent) {
+                if (&I == ctx) {
+                    break;
+                }
+
+                StoreInst* store = dyn_cast<StoreInst>(&I);
+                if (&I == val) {
+                    range = VariableRange();
+                }
+                else if (store && store->getPointerOperand() == val) {
+                    ConstantInt* constant = dyn_cast<ConstantInt>(store->getValueOperand());
+                    int value = constant ? clampConstant(constant->getValue()) : 0;
+                    range = constant ? VariableRange{value, value} : end->second.get(store->getValueOperand());
+                }
+            }
+            return true;
+        }
+
+        /*
+         * Description:
+         * Is the block of ctx reached from the entry, given the ranges of the compares guarding it.
+         */
+        bool isReachable(Instruction* ctx) {
+            if (state->gave_up) {
+                return true;
+            }
+            if (state->ssa_mode) {
+                return isExecutable(ctx->getParent());
+            }
+            return state->basic_block_before_ranges.count(ctx->getParent());
+        }
+
+        // Number of visits the solver needed to converge on the last function analyzed
+        unsigned getSolverIterations() const {
+            return state ? state->solver_iterations : 0;
+        }
+
+        // Did the last function analyzed exceed a budget, so nothing is known about it
+        bool gaveUp() const {
+            return state && state->gave_up;
+        }
+
+    private:
+        // An array access that is not proven in bounds, with the range of its index
+        struct AccessFinding {
+            Instruction* access;
+            int array_size;
+            VariableRange index;
+            bool out_of_bounds;
+        };
+
+        /*
+         * Description:
+         * Everything the analysis knows about the function currently being analyzed. The ranges
+         * stored in the tables share their chunks until they are written to, and all chunks live
+         * in the arena that is dropped together with this state.
+         */
+        struct FunctionState {
+            // Backs every range chunk created while analyzing the function
+            BumpPtrAllocator arena;
+            ValueNumbering numbering;
+
+            // Blocks reachable from the entry in reverse post-order, and the index of each block
+            vector<BasicBlock*> rpo_blocks;
+            unordered_map<BasicBlock*, unsigned> rpo_index;
+
+            // Indices of the blocks that still have to be visited, lowest index first
+            priority_queue<unsigned, vector<unsigned>, greater<unsigned> > worklist;
+            vector<bool> in_worklist;
+
+            // Number of visits until convergence, blocks in memory mode and instructions in SSA mode
+            unsigned solver_iterations = 0;
+
+            // What the solvers did, added to the statistics once the function is solved
+            unsigned blocks_visited = 0;
+            unsigned instructions_transferred = 0;
+            unsigned widenings = 0;
+
+            // When the analysis started, and whether it exceeded a budget. Nothing is known about
+            // the function then, every value could be anything.
+            std::chrono::steady_clock::time_point start_time;
+            unsigned last_time_check = 0;
+            bool gave_up = false;
+
+            // Demand-driven mode: only the slice of the array indices and compares is numbered.
+            // A function without array accesses is skipped, as if it was given up but silently.
+            bool demand_driven = false;
+            bool has_array_accesses = false;
+            bool skipped = false;
+
+            // Bounds widening stops at, sorted, and whether the solver is in its descending phase
+            vector<int> thresholds;
+            bool narrowing = false;
+
+            // Scalar locals whose address escapes, loading from them gives any value
+            SmallPtrSet<Value*, 8> escaped_allocas;
+
+            // Is the function analyzed in SSA form, values instead of allocas carry the ranges
+            bool ssa_mode = false;
+            DominatorTree* dom_tree = nullptr;
+
+            // SSA mode: the range of every value, blocks reached so far, and instructions whose
+            // operands changed. The edges in bb_to_succ_ranges only hold the refined values.
+            Ranges ssa_ranges;
+            vector<bool> executable;
+            SetVector<Instruction*> ssa_worklist;
+
+            // SSA mode: ranges of induction variables known from scalar evolution
+            unordered_map<PHINode*, VariableRange> induction_ranges;
+
+            // Maps each array access and terminator to all of the ranges known right before it
+            unordered_map<Instruction*, Ranges> before_ranges;
+
+            // On entry, the set of ranges of each basic block
+            unordered_map<BasicBlock*, Ranges> basic_block_before_ranges;
+
+            // For each successor to a basic block, denote what range corresponds to that block
+            unordered_map<BasicBlock*, unordered_map<BasicBlock*, Ranges> > bb_to_succ_ranges;
+
+            // The indices into arrays of every array access, with the sizes their types give
+            unordered_map<Instruction*, vector<ArrayIndex> > array_indices;
+
+            // Accesses into heap arrays, their size is only known once the ranges are
+            unordered_map<Instruction*, HeapAccess> heap_accesses;
+
+            // Array accesses that are not proven in bounds, in program order
+            vector<AccessFinding> findings;
+
+            // Indices of array accesses that are not proven to be in bounds
+            vector<ArrayIndex> unproven_accesses;
+            unsigned num_proven_safe = 0;
+            unsigned num_unproven = 0;
+            unsigned num_out_of_bounds = 0;
+
+            // Shared target of all failing guards, created when the first guard is inserted
+            BasicBlock* trap_block = nullptr;
+
+            // Loops of the function and their induction variables
+            LoopInfo* loop_info = nullptr;
+            ScalarEvolution* scalar_evolution = nullptr;
+
+            // Loops with accesses that are checked once in front of the loop
+            MapVector<Loop*, vector<AffineAccess> > hoisted_accesses;
+
+            FunctionState() : numbering(arena) {}
+        };
+
+        unique_ptr<FunctionState> state;
+
+        // Summaries of the functions of the module, only set by the interprocedural analysis
+        const SummaryMap* summaries = nullptr;
+
+        // Frequencies of the blocks of the function analyzed, only set with -BoundsCheck-profile
+        BlockFrequencyInfo* block_frequency = nullptr;
+
+        // Threads analyzers solve on at once, set by the module mode
+        unsigned solver_threads = 1;
+
+        // Where the findings go, the one of the passes without one
+        BoundsCheckReport* report = nullptr;
+
+        BoundsCheckReport& getReport() {
+            return report ? *report : getPassReport();
+        }
+
+        // The messages of the transforms only go with the text warnings, not into the records
+        raw_ostream& getOutput() {
+            BoundsCheckReport& output = getReport();
+            return output.getFormat() == BoundsCheckReport::FORMAT_TEXT ? output.getStream() : errs();
+        }
+
+        /*
+         * Description:
+         * The finding as it is reported, with its source position and array name.
+         */
+        BoundsCheckFinding describeFinding(const AccessFinding& finding) {
+            BoundsCheckFinding described;
+            described.access = finding.access;
+            described.array_size = finding.array_size;
+            described.index_min = finding.index.min_value;
+            described.index_max = finding.index.max_value;
+            described.out_of_bounds = finding.out_of_bounds;
+
+            if (DILocation* loc = finding.access->getDebugLoc()) {
+                SmallString<128> file(loc->getFilename());
+                if (sys::path::is_relative(file) && !loc->getDirectory().empty()) {
+                    file = loc->getDirectory();
+                    sys::path::append(file, loc->getFilename());
+                }
+                described.file = std::string(file.str());
+                described.line = loc->getLine();
+                described.column = loc->getColumn();
+            }
+            else {
+                described.file = finding.access->getModule()->getSourceFileName();
+            }
+
+            // The variable of the source, its value only keeps the name in builds that keep names
+            Value* array = finding.access->getOperand(0)->stripPointerCasts();
+            while (GEPOperator* row = dyn_cast<GEPOperator>(array)) {
+                // A row or field of a larger object, named after the object
+                array = row->getPointerOperand()->stripPointerCasts();
+            }
+            if (LoadInst* load = dyn_cast<LoadInst>(array)) {
+                // A heap array, named after the local holding its pointer
+                array = load->getPointerOperand();
+            }
+            described.array = array->getName().str();
+            for (auto* declare : FindDbgAddrUses(array)) {
+                described.array = declare->getVariable()->getName().str();
+                break;
+            }
+            return described;
+        }
+    };
+
+    /*
+     * Description:
+     * The options the result of a function depends on, part of its key in the result cache.
+     */
+    std::string getCacheOptions() {
+        return "mode " + std::to_string(Mode) + " narrowing " + std::to_string(NarrowingRounds) +
+               " iterations " + std::to_string(MaxSolverIterations) + " values " + std::to_string(MaxTrackedValues) +
+               " relational " + std::to_string(RelationalChecks ? MaxRelatedValues : 0) +
+               " demand " + std::to_string(DemandDriven) + " profile " + std::to_string(ProfileGuided);
+    }
+
+    /*
+     * Description:
+     * Reports the accesses of F from the result cache if it holds an entry for F as it is now.
+     * Returns false if F has to be analyzed. The cache only holds what reporting needs, so it is
+     * not used when a transform is selected, nor for ranking by block frequencies.
+     */
+    bool reportFromCache(Function& F, BoundsCheckReport* report = nullptr) {
+        if (CacheDirectory.empty() || EliminateChecks || GuardAccesses || AnnotateRanges || ProfileGuided) {
+            return false;
+        }
+
+        CachedResult result;
+        RangeAnalyzer analyzer;
+        analyzer.setReport(report);
+        ResultCache cache(CacheDirectory);
+        if (!cache.lookup(ResultCache::hashFunction(F, getCacheOptions()), result) ||
+            !analyzer.restoreCachedResult(F, result)) {
+            return false;
+        }
+
+        ++NumCacheHits;
+        analyzer.reportAccesses(F);
+        return true;
+    }
+
+    /*
+     * Description:
+     * Writes what analyzer found in F to the result cache, if there is one.
+     */
+    void storeInCache(RangeAnalyzer& analyzer, Function& F) {
+        // Running out of time depends on the machine, not on F
+        if (CacheDirectory.empty() || analyzer.gaveUp()) {
+            return;
+        }
+
+        ++NumCacheMisses;
+        ResultCache cache(CacheDirectory);
+        cache.store(ResultCache::hashFunction(F, getCacheOptions()), analyzer.getCachedResult(F));
+    }
+
+    /*
+     * Description:
+     * Applies the transforms selected on the command line to F, which analyzer just analyzed.
+     * Returns true if F changed.
+     */
+    bool transformFunction(RangeAnalyzer& analyzer, Function& F) {
+        // Decide which runtime checks can go before the guards change the CFG
+        vector<pair<BranchInst*, unsigned> > removable;
+        if (EliminateChecks) {
+            removable = analyzer.findRedundantChecks(F);
+        }
+
+        // Only the transforms change the function, the analysis alone does not. The annotations
+        // go first, so the copies made by the guards carry them as well.
+        bool changed = false;
+        if (AnnotateRanges) {
+            changed |= analyzer.annotateRanges(F);
+        }
+        if (GuardAccesses) {
+            changed |= analyzer.guardAccesses(F);
+        }
+        if (EliminateChecks) {
+            changed |= analyzer.eliminateChecks(F, removable);
+        }
+        return changed;
+    }
+
+    /*
+     * Description:
+     * Interprocedural range analysis. The functions of a module are analyzed bottom-up over the
+     * strongly connected components of the call graph, so a call is bounded by the summary of its
+     * callee. The ranges passed at the call sites bound the arguments of the callees in the next
+     * round. A round is only sound if every call passes arguments within the ranges its callee was
+     * analyzed with, arguments that do not hold are widened until they do.
+     *
+     * Components whose callees are all solved are independent of each other and solved on a
+     * thread pool. Everything that changes the IR or prints runs on the calling thread, in the
+     * same bottom-up order whatever the number of threads.
+     */
+    class ModuleRangeAnalyzer {
+    public:
+        // The warnings go to report, or to stderr without one
+        explicit ModuleRangeAnalyzer(BoundsCheckReport* report = nullptr) : report(report) {}
+
+        /*
+         * Description:
+         * Solves the summaries of M, then checks and transforms every function with them. Returns
+         * the functions that changed.
+         */
+        vector<Function*> run(Module& M) {
+            collectFunctions(M);
+
+            TargetLibraryInfoImpl library_info_impl(Triple(M.getTargetTriple()));
+            TargetLibraryInfo library_info(library_info_impl);
+
+            unsigned threads = Threads ? Threads : std::thread::hardware_concurrency();
+            if (threads > 1) {
+#if LLVM_VERSION_MAJOR >= 10
+                pool.reset(new ThreadPool(hardware_concurrency(threads)));
+#else
+                pool.reset(new ThreadPool(threads));
+#endif
+                pool_size = threads;
+            }
+            batch_size = max(threads, 1u) * FUNCTIONS_PER_THREAD;
+
+            for (unsigned round = 0;; ++round) {
+                unordered_map<Function*, vector<VariableRange> > incoming;
+                for (auto& summary : summaries) {
+                    summary.second.solved = false;
+                }
+
+                for (const vector<unsigned>& level : levels) {
+                    for (unsigned begin = 0; begin < level.size(); begin += batch_size) {
+                        vector<unsigned> batch(level.begin() + begin,
+                                               level.begin() + std::min<size_t>(begin + batch_size, level.size()));
+                        solveComponents(batch, library_info, incoming);
+                    }
+                }
+
+                LLVM_DEBUG(dbgs() << "BoundsCheck: summary round " << round << " done\n");
+                if (!updateArguments(incoming, round)) {
+                    break;
+                }
+            }
+
+            for (Function* F : bottom_up) {
+                for (const VariableRange& argument : summaries[F].arguments) {
+                    NumArgumentsBounded += !(argument == VariableRange());
+                }
+            }
+
+            // The solved summaries only depend on the calls, transforming a callee keeps them valid
+            vector<Function*> changed;
+            for (unsigned begin = 0; begin < bottom_up.size(); begin += batch_size) {
+                vector<unique_ptr<FunctionContext> > contexts;
+                vector<std::function<void()> > tasks;
+                for (unsigned i = begin; i < std::min<size_t>(begin + batch_size, bottom_up.size()); ++i) {
+                    contexts.emplace_back(prepareFunction(*bottom_up[i], library_info));
+                    FunctionContext* context = contexts.back().get();
+                    tasks.push_back([context] { context->analyzer.solve(context->function); });
+                }
+                runTasks(tasks);
+
+                for (unique_ptr<FunctionContext>& context : contexts) {
+                    context->analyzer.reportAccesses(context->function);
+                    if (transformFunction(context->analyzer, context->function)) {
+                        changed.push_back(&context->function);
+                    }
+                }
+            }
 
-                    // Create a new range
-                    Ranges unioned;
-                    
-                    bool valid = !current->hasNPredecessorsOrMore(1);
-
-                    // If this basic block has a predecessor, intersect the ranges of them
-                    if (!valid) {
-                        // Get the first predecessor and set it to unioned
-                        bool initialized = false;
-
-                        // Go through all predecessors to merge
-                        for (BasicBlock* pred : predecessors(current)) {
-                            if (bb_to_succ_ranges.count(pred)) {
-                                if (bb_to_succ_ranges[pred].count(current)) {
-                                    if (!initialized) {
-                                        unioned = bb_to_succ_ranges[pred][current];
-                                        initialized = true;
-                                        valid = true;
-                                    }
-                                    else {
-                                        intersectRanges(unioned, bb_to_succ_ranges[pred][current]);
-                                    }
-                                }
-                            }
-                        }
+            pool.reset();
+            return changed;
+        }
+
+    private:
+        /*
+         * Description:
+         * The analyses of one function and its ranges. The module analyzer builds them itself, the
+         * pass managers cannot hand out the analyses of several functions at once.
+         */
+        struct FunctionContext {
+            FunctionContext(Function& F, TargetLibraryInfo& TLI)
+                : function(F), dom_tree(F), loop_info(dom_tree), assumptions(F),
+                  scalar_evolution(F, TLI, assumptions, dom_tree, loop_info) {
+                if (ProfileGuided) {
+                    branch_probability.reset(new BranchProbabilityInfo(F, loop_info, &TLI));
+                    block_frequency.reset(new BlockFrequencyInfo(F, *branch_probability, loop_info));
+                    analyzer.setBlockFrequency(block_frequency.get());
+                }
+            }
+
+            Function& function;
+            DominatorTree dom_tree;
+            LoopInfo loop_info;
+            AssumptionCache assumptions;
+            ScalarEvolution scalar_evolution;
+
+            // Only built with -BoundsCheck-profile
+            unique_ptr<BranchProbabilityInfo> branch_probability;
+            unique_ptr<BlockFrequencyInfo> block_frequency;
+            RangeAnalyzer analyzer;
+
+            // The arguments the calls of the function pass to each callee
+            unordered_map<Function*, vector<VariableRange> > passed;
+        };
+
+        /*
+         * Description:
+         * Builds the analyses of F and runs everything of its range analysis that has to stay on
+         * this thread.
+         */
+        FunctionContext* prepareFunction(Function& F, TargetLibraryInfo& TLI) {
+            FunctionContext* context = new FunctionContext(F, TLI);
+            context->analyzer.setSummaries(&summaries);
+            context->analyzer.setSolverThreads(pool ? pool_size : 1);
+            context->analyzer.setReport(report);
+            context->analyzer.prepare(F, context->dom_tree, context->loop_info, context->scalar_evolution);
+            return context;
+        }
+
+        /*
+         * Description:
+         * Runs the tasks on the pool and waits for all of them, or one after another without one.
+         */
+        void runTasks(const vector<std::function<void()> >& tasks) {
+            if (!pool || tasks.size() < 2) {
+                for (const std::function<void()>& task : tasks) {
+                    task();
+                }
+                return;
+            }
+
+            for (const std::function<void()>& task : tasks) {
+                pool->async(task);
+            }
+            pool->wait();
+        }
+
+        /*
+         * Description:
+         * Solves the given components, which do not call each other. The functions of a component
+         * are solved one after another, the later ones may call the earlier ones. Only the summaries
+         * of the functions solved are written, and the arguments they pass are joined into incoming
+         * afterwards, in order.
+         */
+        void solveComponents(const vector<unsigned>& components, TargetLibraryInfo& TLI,
+                             unordered_map<Function*, vector<VariableRange> >& incoming) {
+            vector<unique_ptr<FunctionContext> > contexts;
+            vector<unsigned> firsts;
+            for (unsigned component : components) {
+                firsts.push_back(contexts.size());
+                for (Function* F : sccs[component]) {
+                    contexts.emplace_back(prepareFunction(*F, TLI));
+                }
+            }
+            firsts.push_back(contexts.size());
+
+            vector<std::function<void()> > tasks;
+            for (unsigned i = 0; i + 1 < firsts.size(); ++i) {
+                unsigned first = firsts[i];
+                unsigned last = firsts[i + 1];
+                tasks.push_back([this, &contexts, first, last] {
+                    for (unsigned j = first; j < last; ++j) {
+                        FunctionContext& context = *contexts[j];
+                        context.analyzer.solve(context.function);
+
+                        FunctionSummary& summary = summaries.at(&context.function);
+                        summary.returned = context.analyzer.getReturnedRange(context.function);
+                        summary.solved = true;
+                        context.analyzer.collectCallArguments(context.function, context.passed);
                     }
+                });
+            }
+            runTasks(tasks);
 
-                    // No predecessors reached this block and this is not the entry block.
-                    if (!valid) {
+            for (unique_ptr<FunctionContext>& context : contexts) {
+                for (auto& passed : context->passed) {
+                    auto joined = incoming.find(passed.first);
+                    if (joined == incoming.end()) {
+                        incoming.insert(passed);
                         continue;
                     }
+                    for (unsigned i = 0; i < passed.second.size(); ++i) {
+                        joined->second[i] = unionRange(joined->second[i], passed.second[i]);
+                    }
+                }
+            }
+        }
 
-                    // Update the before range appropriately, mark if there is any change.
-                    if (basic_block_before_ranges.count(current)) {
-                        if (!equal_ranges(basic_block_before_ranges[current], unioned)) {
-                            changed = true;
-                            basic_block_before_ranges[current] = unioned;
-                        }
+        /*
+         * Description:
+         * Orders the defined functions bottom-up and decides whose arguments are bounded by their
+         * call sites: the ones only called directly from within the module. The components are
+         * grouped into levels, a component only calls components of lower levels.
+         */
+        void collectFunctions(Module& M) {
+            CallGraph call_graph(M);
+            unordered_map<Function*, unsigned> component_of;
+            vector<unsigned> component_level;
+            for (scc_iterator<CallGraph*> scc = scc_begin(&call_graph); !scc.isAtEnd(); ++scc) {
+                vector<Function*> component;
+                for (CallGraphNode* node : *scc) {
+                    Function* F = node->getFunction();
+                    if (F && !F->isDeclaration()) {
+                        component.push_back(F);
                     }
-                    else {
-                        changed = true;
-                        basic_block_before_ranges[current] = unioned;
+                }
+                if (component.empty()) {
+                    continue;
+                }
+
+                // Callees come first, their levels are known
+                unsigned level = 0;
+                for (CallGraphNode* node : *scc) {
+                    for (auto& callee : *node) {
+                        auto callee_component = component_of.find(callee.second->getFunction());
+                        if (callee_component != component_of.end()) {
+                            level = max(level, component_level[callee_component->second] + 1);
+                        }
                     }
+                }
+
+                for (Function* F : component) {
+                    component_of[F] = sccs.size();
+                    bottom_up.push_back(F);
+                    summaries[F].arguments.assign(F->arg_size(), VariableRange());
+                }
+                if (level >= levels.size()) {
+                    levels.resize(level + 1);
+                }
+                levels[level].push_back(sccs.size());
+                component_level.push_back(level);
+                sccs.push_back(component);
+            }
+
+            for (Function* F : bottom_up) {
+                bool internal = F->hasLocalLinkage() || (WholeProgram && F->getName() != "main");
+                if (internal && !F->hasAddressTaken()) {
+                    bounded.insert(F);
+                }
+            }
+        }
+
+        /*
+         * Description:
+         * Bounds the arguments by what the calls of the last round passed. The first round runs
+         * with nothing known about the arguments and always holds, after it the arguments are
+         * narrowed to their call sites once. A later argument that does not contain what is passed
+         * to it is joined with it, and given up once the rounds run out. Returns true if another
+         * round is needed.
+         */
+        bool updateArguments(const unordered_map<Function*, vector<VariableRange> >& incoming, unsigned round) {
+            bool changed = false;
+            for (Function* F : bounded) {
+                auto passed = incoming.find(F);
+                if (passed == incoming.end()) {
+                    continue;
+                }
 
-                    // Update the variables in the function. If there are any changes, denote them
-                    for (Instruction& I : *current) {
-                        changed = handleInst(&I, unioned) || changed;
+                vector<VariableRange>& arguments = summaries[F].arguments;
+                for (unsigned i = 0; i < arguments.size(); ++i) {
+                    VariableRange updated = arguments[i];
+                    if (round == 0) {
+                        updated = passed->second[i];
+                    }
+                    else if (!containsRange(arguments[i], passed->second[i])) {
+                        updated = round + 1 < SummaryRounds ? unionRange(arguments[i], passed->second[i])
+                                                            : VariableRange();
                     }
-                            
+
+                    changed |= !(updated == arguments[i]);
+                    arguments[i] = updated;
                 }
+            }
+            return changed;
+        }
+
+        vector<Function*> bottom_up;
+        SummaryMap summaries;
+
+        // Functions whose arguments are bounded by their call sites
+        SetVector<Function*> bounded;
+
+        // The strongly connected components bottom-up, and the components of each level
+        vector<vector<Function*> > sccs;
+        vector<vector<unsigned> > levels;
+
+        // Solves the components of a level, none if there is only one thread, and its threads
+        unique_ptr<ThreadPool> pool;
+        unsigned pool_size = 1;
+        unsigned batch_size = FUNCTIONS_PER_THREAD;
+
+        BoundsCheckReport* report;
+    };
+}
+
+// ================== BEGIN LIBRARY INTERFACE ================== //
+
+/*
+ * Description:
+ * Writes text as a JSON string, quotes included.
+ */
+static void writeJSONString(raw_ostream& os, StringRef text) {
+    os << '"';
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        }
+        else if (c == '\n') {
+            os << "\\n";
+        }
+        else if (c < 0x20) {
+            os << format("\\u%04x", c);
+        }
+        else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+BoundsCheckReport::~BoundsCheckReport() {
+    finishModule();
+    os.flush();
+}
 
+void BoundsCheckReport::beginModule(StringRef name) {
+    if (in_module && module == name) {
+        return;
+    }
+    finishModule();
+
+    module = name.str();
+    in_module = true;
+    module_counts = Counts();
+    first_result = true;
+
+    if (format == FORMAT_SARIF) {
+        if (num_modules) {
+            os << ",\n";
+        }
+        os << "{\"tool\":{\"driver\":{\"name\":\"BoundsCheck\",\"rules\":["
+           << "{\"id\":\"out-of-bounds\",\"shortDescription\":{\"text\":\"Array access always out of bounds\"}},"
+           << "{\"id\":\"unproven\",\"shortDescription\":{\"text\":\"Array access not proven in bounds\"}}]}},"
+           << "\"results\":[\n";
+    }
+}
+
+void BoundsCheckReport::addFunction(const Function& F, const Counts& function,
+                                    const std::vector<BoundsCheckFinding>& findings) {
+    beginModule(F.getParent()->getModuleIdentifier());
+    for (const BoundsCheckFinding& finding : findings) {
+        writeFinding(F, finding);
+    }
+    counts += function;
+    module_counts += function;
+}
+
+void BoundsCheckReport::finishModule() {
+    if (!in_module) {
+        return;
+    }
+    writeSummary();
+    in_module = false;
+    ++num_modules;
+}
+
+void BoundsCheckReport::beginSARIF(raw_ostream& os) {
+    os << "{\"version\":\"2.1.0\",\"$schema\":\"https://json.schemastore.org/sarif-2.1.0.json\",\"runs\":[\n";
+}
+
+void BoundsCheckReport::endSARIF(raw_ostream& os) {
+    os << "]}\n";
+}
+
+/*
+ * Description:
+ * Writes one finding in the format of the report. The text format only warns about the accesses
+ * that are always out of bounds, as the passes always did.
+ */
+void BoundsCheckReport::writeFinding(const Function& F, const BoundsCheckFinding& finding) {
+    const char* verdict = finding.out_of_bounds ? "out-of-bounds" : "unproven";
+    switch (format) {
+        case FORMAT_TEXT: {
+            if (!finding.out_of_bounds) {
+                return;
             }
 
-            // Get all of the arrays
-            getArrayInformation(F);
+            DILocation* loc = finding.access->getDebugLoc();
+            if (!loc) {
+                os << "WARNING: Array out of bounds access at ";
+                os << *finding.access << "\n";
+                os << "Please compile with -g to see line numbers.\n";
+            }
+            else {
+                os << loc->getFilename() << ":" << loc->getLine() << ":";
+                os << loc->getColumn() << ": warning: Array out of bounds access.\n";
+            }
+            return;
+        }
+        case FORMAT_JSON_LINES: {
+            os << "{\"type\":\"access\",\"module\":";
+            writeJSONString(os, module);
+            os << ",\"function\":";
+            writeJSONString(os, F.getName());
+            os << ",\"file\":";
+            writeJSONString(os, finding.file);
+            if (finding.line) {
+                os << ",\"line\":" << finding.line << ",\"column\":" << finding.column;
+            }
+            else {
+                os << ",\"line\":null,\"column\":null";
+            }
+            os << ",\"array\":";
+            writeJSONString(os, finding.array);
+            os << ",\"array_size\":" << finding.array_size << ",\"index_min\":" << finding.index_min
+               << ",\"index_max\":" << finding.index_max << ",\"verdict\":\"" << verdict << "\"";
+            if (finding.execution_count) {
+                os << ",\"execution_count\":" << *finding.execution_count;
+            }
+            os << "}\n";
+            return;
+        }
+        case FORMAT_SARIF: {
+            std::string message;
+            raw_string_ostream text(message);
+            text << "Index of " << finding.array << " (size " << finding.array_size << ") is in ["
+                 << finding.index_min << ", " << finding.index_max << "]"
+                 << (finding.out_of_bounds ? ", always out of bounds." : ", not proven in bounds.");
+            text.flush();
 
-            // Check to see if range is out of bounds
-            checkArrayBounds(F);
+            os << (first_result ? "" : ",\n") << "{\"ruleId\":\"" << verdict << "\",\"level\":\""
+               << (finding.out_of_bounds ? "warning" : "note") << "\",\"message\":{\"text\":";
+            writeJSONString(os, message);
+            os << "},\"locations\":[{\"physicalLocation\":{\"artifactLocation\":{\"uri\":";
+            writeJSONString(os, finding.file);
+            os << "}";
+            if (finding.line) {
+                os << ",\"region\":{\"startLine\":" << finding.line;
+                if (finding.column) {
+                    os << ",\"startColumn\":" << finding.column;
+                }
+                os << "}";
+            }
+            os << "}}],\"properties\":{\"function\":";
+            writeJSONString(os, F.getName());
+            os << ",\"array\":";
+            writeJSONString(os, finding.array);
+            os << ",\"arraySize\":" << finding.array_size << ",\"indexMin\":" << finding.index_min
+               << ",\"indexMax\":" << finding.index_max;
+            if (finding.execution_count) {
+                os << ",\"executionCount\":" << *finding.execution_count;
+            }
+            os << "}}";
+            first_result = false;
+            return;
+        }
+    }
+}
+
+/*
+ * Description:
+ * Writes the counts of the module being reported, and ends its run in SARIF.
+ */
+void BoundsCheckReport::writeSummary() {
+    const Counts& summary = module_counts;
+    switch (format) {
+        case FORMAT_TEXT:
+            return;
+        case FORMAT_JSON_LINES:
+            os << "{\"type\":\"summary\",\"module\":";
+            writeJSONString(os, module);
+            os << ",\"functions\":" << summary.num_functions << ",\"proven_safe\":" << summary.num_proven_safe
+               << ",\"unproven\":" << summary.num_unproven << ",\"out_of_bounds\":" << summary.num_out_of_bounds
+               << ",\"given_up\":" << summary.num_given_up << "}\n";
+            return;
+        case FORMAT_SARIF:
+            os << "\n],\"properties\":{\"module\":";
+            writeJSONString(os, module);
+            os << ",\"functions\":" << summary.num_functions << ",\"provenSafe\":" << summary.num_proven_safe
+               << ",\"unproven\":" << summary.num_unproven << ",\"outOfBounds\":" << summary.num_out_of_bounds
+               << ",\"givenUp\":" << summary.num_given_up << "}}";
+            return;
+    }
+}
+
+BoundsCheckReport::Format getReportFormat() {
+    return ReportFormat;
+}
+
+void initializeBoundsCheck() {
+    setRangeKernels(SIMDKernels);
+}
+
+/*
+ * Description:
+ * Checks the functions of M without a pass manager. Each function gets the analyses
+ * BoundsCheckPass asks for, built here, and nothing is shared with other modules.
+ */
+bool checkModuleBounds(Module& M, bool interprocedural, BoundsCheckReport& report) {
+    report.beginModule(M.getModuleIdentifier());
+    if (interprocedural) {
+        ModuleRangeAnalyzer module_analyzer(&report);
+        bool changed = !module_analyzer.run(M).empty();
+        report.finishModule();
+        return changed;
+    }
+
+    TargetLibraryInfoImpl library_info_impl(Triple(M.getTargetTriple()));
+    TargetLibraryInfo library_info(library_info_impl);
+
+    bool changed = false;
+    for (Function& F : M) {
+        if (F.isDeclaration() || reportFromCache(F, &report)) {
+            continue;
+        }
+
+        DominatorTree dom_tree(F);
+        LoopInfo loop_info(dom_tree);
+        AssumptionCache assumptions(F);
+        ScalarEvolution scalar_evolution(F, library_info, assumptions, dom_tree, loop_info);
+        unique_ptr<BranchProbabilityInfo> branch_probability;
+        unique_ptr<BlockFrequencyInfo> block_frequency;
+        if (ProfileGuided) {
+            branch_probability.reset(new BranchProbabilityInfo(F, loop_info, &library_info));
+            block_frequency.reset(new BlockFrequencyInfo(F, *branch_probability, loop_info));
+        }
+
+        RangeAnalyzer analyzer;
+        analyzer.setReport(&report);
+        analyzer.setBlockFrequency(block_frequency.get());
+        analyzer.analyze(F, dom_tree, loop_info, scalar_evolution);
+        storeInCache(analyzer, F);
+        analyzer.reportAccesses(F);
+        changed |= transformFunction(analyzer, F);
+    }
+    report.finishModule();
+    return changed;
+}
+
+// ================== END LIBRARY INTERFACE ================== //
+
+// ================== BEGIN NEW PASS MANAGER ================== //
+
+// Keeps the analyzer, which lives in the anonymous namespace, behind the public result
+struct ValueRangeInfo::Impl {
+    RangeAnalyzer analyzer;
+};
+
+ValueRangeInfo::ValueRangeInfo(unique_ptr<Impl> impl) : impl(std::move(impl)) {}
+ValueRangeInfo::ValueRangeInfo(ValueRangeInfo&& other) = default;
+ValueRangeInfo& ValueRangeInfo::operator=(ValueRangeInfo&& other) = default;
+ValueRangeInfo::~ValueRangeInfo() = default;
+
+VariableRange ValueRangeInfo::getRange(Value* val, Instruction* ctx) const {
+    VariableRange range;
+    if (!impl->analyzer.getRange(val, ctx, range)) {
+        return VariableRange();
+    }
+    return range;
+}
+
+bool ValueRangeInfo::isReachable(Instruction* ctx) const {
+    return impl->analyzer.isReachable(ctx);
+}
+
+unsigned ValueRangeInfo::getSolverIterations() const {
+    return impl->analyzer.getSolverIterations();
+}
+
+bool ValueRangeInfo::invalidate(Function& F, const PreservedAnalyses& PA,
+                                FunctionAnalysisManager::Invalidator& inv) {
+    auto checker = PA.getChecker<ValueRangeAnalysis>();
+    if (!checker.preserved() && !checker.preservedSet<AllAnalysesOn<Function> >()) {
+        return true;
+    }
+
+    return inv.invalidate<DominatorTreeAnalysis>(F, PA) || inv.invalidate<LoopAnalysis>(F, PA) ||
+           inv.invalidate<ScalarEvolutionAnalysis>(F, PA) ||
+           (ProfileGuided && inv.invalidate<BlockFrequencyAnalysis>(F, PA));
+}
+
+AnalysisKey ValueRangeAnalysis::Key;
+
+ValueRangeInfo ValueRangeAnalysis::run(Function& F, FunctionAnalysisManager& FAM) {
+    unique_ptr<ValueRangeInfo::Impl> impl(new ValueRangeInfo::Impl());
+    impl->analyzer.setBlockFrequency(ProfileGuided ? &FAM.getResult<BlockFrequencyAnalysis>(F) : nullptr);
+    impl->analyzer.analyze(F, FAM.getResult<DominatorTreeAnalysis>(F), FAM.getResult<LoopAnalysis>(F),
+                           FAM.getResult<ScalarEvolutionAnalysis>(F));
+    return ValueRangeInfo(std::move(impl));
+}
+
+namespace {
+    // Warns about the array accesses that are always out of bounds, changes nothing
+    struct BoundsCheckPrinterPass : PassInfoMixin<BoundsCheckPrinterPass> {
+        PreservedAnalyses run(Function& F, FunctionAnalysisManager& FAM) {
+            // An unchanged function is not analyzed at all
+            if (reportFromCache(F)) {
+                return PreservedAnalyses::all();
+            }
+
+            RangeAnalyzer& analyzer = FAM.getResult<ValueRangeAnalysis>(F).getImpl().analyzer;
+            storeInCache(analyzer, F);
+            analyzer.reportAccesses(F);
+            return PreservedAnalyses::all();
+        }
+    };
+
+    // Removes the runtime checks the ranges prove to never fail
+    struct BoundsCheckEliminatePass : PassInfoMixin<BoundsCheckEliminatePass> {
+        PreservedAnalyses run(Function& F, FunctionAnalysisManager& FAM) {
+            RangeAnalyzer& analyzer = FAM.getResult<ValueRangeAnalysis>(F).getImpl().analyzer;
+            if (!analyzer.eliminateChecks(F, analyzer.findRedundantChecks(F))) {
+                return PreservedAnalyses::all();
+            }
+            return PreservedAnalyses::none();
+        }
+    };
+
+    // Writes the ranges into the IR, keeps the CFG as it is
+    struct BoundsCheckAnnotatePass : PassInfoMixin<BoundsCheckAnnotatePass> {
+        PreservedAnalyses run(Function& F, FunctionAnalysisManager& FAM) {
+            if (!FAM.getResult<ValueRangeAnalysis>(F).getImpl().analyzer.annotateRanges(F)) {
+                return PreservedAnalyses::all();
+            }
+
+            PreservedAnalyses PA;
+            PA.preserveSet<CFGAnalyses>();
+            return PA;
+        }
+    };
+
+    // The interprocedural analysis, checks and transforms every function like -BoundsCheck-module
+    struct BoundsCheckInterproceduralPass : PassInfoMixin<BoundsCheckInterproceduralPass> {
+        PreservedAnalyses run(Module& M, ModuleAnalysisManager& MAM) {
+            FunctionAnalysisManager& FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+            ModuleRangeAnalyzer module_analyzer;
+            vector<Function*> changed = module_analyzer.run(M);
+            getPassReport().finishModule();
+            for (Function* F : changed) {
+                FAM.invalidate(*F, PreservedAnalyses::none());
+            }
+            return changed.empty() ? PreservedAnalyses::all() : PreservedAnalyses::none();
+        }
+    };
+
+    // Guards the array accesses that are not proven in bounds
+    struct BoundsCheckGuardPass : PassInfoMixin<BoundsCheckGuardPass> {
+        PreservedAnalyses run(Function& F, FunctionAnalysisManager& FAM) {
+            if (!FAM.getResult<ValueRangeAnalysis>(F).getImpl().analyzer.guardAccesses(F)) {
+                return PreservedAnalyses::all();
+            }
+            return PreservedAnalyses::none();
+        }
+    };
+}
+
+// opt -load-pass-plugin LLVMJPT.so -passes=bounds-check,bounds-check-eliminate
+extern "C" LLVM_ATTRIBUTE_WEAK PassPluginLibraryInfo llvmGetPassPluginInfo() {
+    return {LLVM_PLUGIN_API_VERSION, "BoundsCheck", LLVM_VERSION_STRING, [](PassBuilder& PB) {
+        PB.registerAnalysisRegistrationCallback([](FunctionAnalysisManager& FAM) {
+            setRangeKernels(SIMDKernels);
+            FAM.registerPass([] { return ValueRangeAnalysis(); });
+        });
+
+        PB.registerPipelineParsingCallback(
+            [](StringRef name, FunctionPassManager& FPM, ArrayRef<PassBuilder::PipelineElement>) {
+                if (name == "bounds-check") {
+                    FPM.addPass(BoundsCheckPrinterPass());
+                    return true;
+                }
+                if (name == "bounds-check-eliminate") {
+                    FPM.addPass(BoundsCheckEliminatePass());
+                    return true;
+                }
+                if (name == "bounds-check-annotate") {
+                    FPM.addPass(BoundsCheckAnnotatePass());
+                    return true;
+                }
+                if (name == "bounds-check-guard") {
+                    FPM.addPass(BoundsCheckGuardPass());
+                    return true;
+                }
+                return false;
+            });
+
+        PB.registerPipelineParsingCallback(
+            [](StringRef name, ModulePassManager& MPM, ArrayRef<PassBuilder::PipelineElement>) {
+                if (name == "bounds-check-module") {
+                    MPM.addPass(BoundsCheckInterproceduralPass());
+                    return true;
+                }
+                return false;
+            });
+    }};
+}
+
+// ================== END NEW PASS MANAGER ================== //
+
+// ================== BEGIN LEGACY PASS MANAGER ================== //
+
+namespace {
+    /*
+     * Description:
+     * A function pass that checks the bounds of statically allocated arrays, and with
+     * -BoundsCheck-eliminate or -BoundsCheck-guard removes or inserts runtime checks.
+     */
+    struct BoundsCheckPass : public FunctionPass {
+        static char ID;
+        BoundsCheckPass() : FunctionPass(ID) {}
+
+        // Necessary for LLVM Passes
+        void getAnalysisUsage(AnalysisUsage &AU) const {
+            AU.addRequired<DominatorTreeWrapperPass>();
+
+            // Induction variables seed the loop headers and let guards be hoisted
+            AU.addRequired<LoopInfoWrapperPass>();
+            AU.addRequired<ScalarEvolutionWrapperPass>();
+
+            // Decides which blocks are hot, from the profile if the module has one
+            if (ProfileGuided) {
+                AU.addRequired<BlockFrequencyInfoWrapperPass>();
+            }
+
+            // Removing checks and inserting guards changes the CFG, annotations only the instructions
+            if (!EliminateChecks && !GuardAccesses) {
+                if (AnnotateRanges) {
+                    AU.setPreservesCFG();
+                }
+                else {
+                    AU.setPreservesAll();
+                }
+            }
+        }
 
-            // Since nothing was changed in the function, return false
+        // Pick the range kernels once per module
+        virtual bool doInitialization(Module& M) {
+            setRangeKernels(SIMDKernels);
             return false;
         }
-    private:
-        // successors of each basic block
-        unordered_map<BasicBlock*, vector<BasicBlock*>> bb_succs;
 
-        // Maps each instruction to all of the ranges known at that point in the program
-        unordered_map<Instruction*, Ranges> inst_to_ranges;
+        // The summary of the module follows its last function
+        virtual bool doFinalization(Module& M) {
+            getPassReport().finishModule();
+            return false;
+        }
+
+        virtual bool runOnFunction(Function &F) {
+            // The analyses asked for are computed anyway, the ranges are not
+            if (reportFromCache(F)) {
+                return false;
+            }
+
+            analyzer.setBlockFrequency(ProfileGuided ? &getAnalysis<BlockFrequencyInfoWrapperPass>().getBFI() : nullptr);
+            analyzer.analyze(F, getAnalysis<DominatorTreeWrapperPass>().getDomTree(),
+                             getAnalysis<LoopInfoWrapperPass>().getLoopInfo(),
+                             getAnalysis<ScalarEvolutionWrapperPass>().getSE());
+            storeInCache(analyzer, F);
+            analyzer.reportAccesses(F);
+            return transformFunction(analyzer, F);
+        }
+
+        // Number of visits the solver needed to converge on the last function analyzed
+        unsigned getSolverIterations() const {
+            return analyzer.getSolverIterations();
+        }
+
+    private:
+        RangeAnalyzer analyzer;
+    };
+}
 
-        // On entry, the set of ranges of each basic block
-        unordered_map<BasicBlock*, Ranges> basic_block_before_ranges;
+namespace {
+    /*
+     * Description:
+     * The interprocedural version of BoundsCheckPass. Calls are bounded by the summaries of their
+     * callees and arguments by their call sites, then every function is checked and transformed
+     * like BoundsCheckPass does.
+     */
+    struct BoundsCheckModulePass : public ModulePass {
+        static char ID;
+        BoundsCheckModulePass() : ModulePass(ID) {}
 
-        // For each successor to a basic block, denote what range corresponds to that block
-        unordered_map<BasicBlock*, unordered_map<BasicBlock*, Ranges> > bb_to_succ_ranges;
+        // The analyses of each function are built by the module analyzer, for several at once
+        void getAnalysisUsage(AnalysisUsage &AU) const {
+            if (!EliminateChecks && !GuardAccesses && !AnnotateRanges) {
+                AU.setPreservesAll();
+            }
+        }
 
-        // Stores the array sizes of all arrays in the function
-        unordered_map<AllocaInst*, int> array_sizes;
+        virtual bool runOnModule(Module& M) {
+            setRangeKernels(SIMDKernels);
+            ModuleRangeAnalyzer module_analyzer;
+            bool changed = !module_analyzer.run(M).empty();
+            getPassReport().finishModule();
+            return changed;
+        }
     };
 }
 
 // Necessary LLVM information
 
 char BoundsCheckPass::ID = 0;
+char BoundsCheckModulePass::ID = 0;
 
 static RegisterPass<BoundsCheckPass> X("BoundsCheck", "Bounds Check Pass");
+static RegisterPass<BoundsCheckModulePass> Y("BoundsCheck-module", "Interprocedural Bounds Check Pass");
 
 static void registerBoundsCheckPass(const PassManagerBuilder &,
                             legacy::PassManagerBase &PM) {
-    PM.add(new BranchProbabilityInfoWrapperPass());
-    PM.add(new BlockFrequencyInfoWrapperPass());                        
     PM.add(new BoundsCheckPass());
 }
 static RegisterStandardPasses
   RegisterMyPass(PassManagerBuilder::EP_EarlyAsPossible,
                  registerBoundsCheckPass);
+
+// ================== END LEGACY PASS MANAGER ================== //